@@ -6,37 +6,86 @@
 #include <Python.h>
 
 
+#define RIDDERS_LEVELS 10
+#define RIDDERS_SAFE 2.
+#define COMPLEX_STEP_SIZE 1e-20
+
+struct Function;
+struct Stencil;
+
+short init_functions(void);
+
 static struct FiniteDifference {
-    double *(*first)(PyObject *f, double *x, double h, unsigned int d);
-    double *(*second)(PyObject *f, double *x, double h, unsigned int d);
-    double *(*nth)(PyObject *f, double *x, double h, unsigned int n, unsigned int d);
+    double *(*first)(struct Function *f, double *x, double h, unsigned int d);
+    double *(*second)(struct Function *f, double *x, double h, unsigned int d);
 };
 static enum FinDiffRule { FORWARD, BACKWARD, CENTRAL };
 
-static double *forward_first(PyObject *f, double *x, double h, unsigned int d);
-static double *forward_second(PyObject *f, double *x, double h, unsigned int d);
-static double *forward_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d);
-static struct FiniteDifference forward = { forward_first, forward_second, forward_nth };
+static double *forward_first(struct Function *f, double *x, double h, unsigned int d);
+static double *forward_second(struct Function *f, double *x, double h, unsigned int d);
+static struct FiniteDifference forward = { forward_first, forward_second };
 
-static double *backward_first(PyObject *f, double *x, double h, unsigned int d);
-static double *backward_second(PyObject *f, double *x, double h, unsigned int d);
-static double *backward_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d);
-static struct FiniteDifference backward = { backward_first, backward_second, backward_nth };
+static double *backward_first(struct Function *f, double *x, double h, unsigned int d);
+static double *backward_second(struct Function *f, double *x, double h, unsigned int d);
+static struct FiniteDifference backward = { backward_first, backward_second };
 
-static double *central_first(PyObject *f, double *x, double h, unsigned int d);
-static double *central_second(PyObject *f, double *x, double h, unsigned int d);
-static double *central_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d);
-static struct FiniteDifference central = { central_first, central_second, central_nth };
+static double *central_first(struct Function *f, double *x, double h, unsigned int d);
+static double *central_second(struct Function *f, double *x, double h, unsigned int d);
+static struct FiniteDifference central = { central_first, central_second };
 
+static double *stencil_differences(
+    struct Function *f, double *x, double h, const struct Stencil *stencil, unsigned int d
+);
 static double *dquotient(
-    PyObject *f, double *x, double h, unsigned int n, unsigned int d,
-    struct FiniteDifference *findiff
+    struct Function *f, double *x, double h, unsigned int n, unsigned int d, enum FinDiffRule rule,
+    const struct Stencil *stencil
+);
+static short ridders(
+    struct Function *f, double *x, double h, unsigned int d, const struct Stencil *stencil, double *res,
+    double *err
+);
+
+typedef void (*StencilRow)(
+    const double *x, unsigned int d, double h, enum FinDiffRule rule, Py_ssize_t k, double *row
+);
+typedef short (*BatchEngine)(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, enum FinDiffRule rule, double *res
+);
+
+static void stencil_row(
+    const double *x, unsigned int d, double h, enum FinDiffRule rule, Py_ssize_t k, double *row
+);
+static void hessian_row(
+    const double *x, unsigned int d, double h, enum FinDiffRule rule, Py_ssize_t k, double *row
+);
+static short eval_stencils(
+    struct Function *f, const double *x, Py_ssize_t count, unsigned int d, double h, enum FinDiffRule rule,
+    StencilRow row, Py_ssize_t stencil, double *block, double *values
+);
+static short gradient(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, enum FinDiffRule rule, double *res
+);
+static short hessian(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, enum FinDiffRule rule, double *res
+);
+static short complex_step(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, double *res
 );
 
 static PyObject *differential_dquotient(PyObject *self, PyObject *args);
+static PyObject *differential_ridders(PyObject *self, PyObject *args);
+static PyObject *differential_gradient(PyObject *self, PyObject *args);
+static PyObject *differential_jacobian(PyObject *self, PyObject *args);
+static PyObject *differential_hessian(PyObject *self, PyObject *args);
+static PyObject *differential_complex_step(PyObject *self, PyObject *args);
 
 static PyMethodDef DifferentialMethods[] = {
     {"dquotient", differential_dquotient, METH_VARARGS, NULL},
+    {"ridders", differential_ridders, METH_VARARGS, NULL},
+    {"gradient", differential_gradient, METH_VARARGS, NULL},
+    {"jacobian", differential_jacobian, METH_VARARGS, NULL},
+    {"hessian", differential_hessian, METH_VARARGS, NULL},
+    {"complex_step", differential_complex_step, METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}
 };
 
@@ -44,4 +93,10 @@ static struct PyModuleDef differential_module = {
     PyModuleDef_HEAD_INIT, "differential", NULL, -1, DifferentialMethods
 };
 
-PyMODINIT_FUNC PyInit_differential() { return PyModule_Create(&differential_module); }
+PyMODINIT_FUNC PyInit_differential() {
+
+    if (init_functions() == -1) { return NULL; }
+
+    return PyModule_Create(&differential_module);
+
+}
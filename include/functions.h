@@ -6,4 +6,44 @@
 #include <Python.h>
 
 
-double eval(PyObject *f, double *x, unsigned int d);
+#define NATIVE_SIGNATURE "double (const double *, unsigned int, void *)"
+#define NATIVE_BLOCKSIZE 1024
+#define PARAMETRIC_SIGNATURE "double (const double *, unsigned int, const double *, unsigned int, void *)"
+#define COMPLEX_SIGNATURE "void (const double *, unsigned int, double *, void *)"
+
+typedef double (*NativeFunction)(const double *x, unsigned int d, void *userdata);
+typedef double (*ParametricFunction)(
+    const double *x, unsigned int d, const double *p, unsigned int q, void *userdata
+);
+typedef void (*ComplexFunction)(const double *z, unsigned int d, double *w, void *userdata);
+
+enum FunctionType { SCALAR, VECTORIZED, NATIVE };
+
+struct Function {
+    enum FunctionType type;
+    PyObject *callable;
+    NativeFunction native;
+    ParametricFunction parametric;
+    ComplexFunction holomorphic;
+    void *userdata;
+    Py_ssize_t blocksize;
+    unsigned int outputs;
+    double *memo;
+};
+short init_functions(void);
+
+struct Function *parse_function(PyObject *ob_f, Py_ssize_t blocksize);
+short probe_function(struct Function *f, double *x, unsigned int d);
+void free_function(struct Function *f);
+
+double eval(struct Function *f, double *x, unsigned int d);
+short eval_block(struct Function *f, double *x, Py_ssize_t N, unsigned int d, double *y);
+
+struct Function *parse_parametric(PyObject *ob_f, Py_ssize_t blocksize);
+short eval_parametric(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double *p, Py_ssize_t P, unsigned int q,
+    double *y
+);
+
+struct Function *parse_complex(PyObject *ob_f, Py_ssize_t blocksize);
+short eval_complex(struct Function *f, double *z, Py_ssize_t N, unsigned int d, double *w);
@@ -4,6 +4,16 @@
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
+#include <structmember.h>
+#include <stdint.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifndef M_PI_2
+#define M_PI_2 1.57079632679489661923
+#endif
 
 
 struct Interval {
@@ -15,6 +25,7 @@ struct Interval *parse_interval(PyObject *ob_interval);
 struct Interval **parse_intervals(PyObject *ob_intervals, unsigned int *d);
 
 double delta(struct Interval **intervals, unsigned int d);
+short bounded(struct Interval **intervals, unsigned int d);
 short endpoint(struct Interval *interval, unsigned int i, double *x);
 
 typedef short (*RiemannRule)(struct Interval *interval, unsigned int i, double *x);
@@ -25,10 +36,136 @@ short midpoint(struct Interval *interval, unsigned int i, double *x);
 enum RiemannRules { LEFT, RIGHT, MIDPOINT };
 enum RiemannRules *parse_rrules(PyObject *ob_rrules);
 
+enum QuadratureRules {
+    GAUSS_LEGENDRE = MIDPOINT + 1, GAUSS_LOBATTO, CLENSHAW_CURTIS, GAUSS_PATTERSON, SIMPSON, TRAPEZOID
+};
+enum QuadratureRules *parse_rules(PyObject *ob_rules);
+
+struct Grid {
+    unsigned int d;
+    unsigned int *sizes;
+    double **nodes;
+    double **weights;
+    uint64_t npoints;
+};
+struct Grid *build_grid(
+    struct Interval **intervals, RiemannRule *rules, unsigned int d, unsigned int extra
+);
+void free_grid(struct Grid *grid);
+
+struct Grid *riemann_grid(struct Interval **intervals, enum RiemannRules *rrules, unsigned int d);
+struct Grid *trapezoidal_grid(struct Interval **intervals, unsigned int d);
+struct Grid *tensor_grid(struct Interval **intervals, enum QuadratureRules *rules, unsigned int d);
+
+struct Odometer {
+    unsigned int *index;
+    double *x;
+    double *w;
+};
+struct Odometer *new_odometer(struct Grid *grid);
+void free_odometer(struct Odometer *odometer);
+void seek_odometer(struct Grid *grid, struct Odometer *odometer, uint64_t radix);
+void step_odometer(struct Grid *grid, struct Odometer *odometer);
+
+enum KronrodRules { GK15 = 15, GK21 = 21 };
+
+struct KronrodRule {
+    unsigned int n;
+    const double *xgk;
+    const double *wgk;
+    const double *wg;
+};
+
 short riemann(
-    PyObject *f, struct Interval **intervals, enum RiemannRules *rrules, unsigned int d, double *res
+    struct Function *f, struct Interval **intervals, enum RiemannRules *rrules, unsigned int d,
+    unsigned int nthreads, double *res
+);
+short trapezoidal(
+    struct Function *f, struct Interval **intervals, unsigned int d, unsigned int nthreads,
+    double *res
+);
+short tensor(
+    struct Function *f, struct Interval **intervals, enum QuadratureRules *rules, unsigned int d,
+    unsigned int nthreads, double *res
+);
+
+short quad(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    enum KronrodRules krule, unsigned int limit, double *res, double *err, uint64_t *neval
+);
+
+short romberg(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    unsigned int maxlevel, double *res, double *err, uint64_t *neval, uint64_t *nreused
+);
+
+#define GP_LEVELS 6
+#define CC_LEVELS 14
+
+
+struct NestedRule {
+    unsigned int levels;
+    unsigned int *sizes;
+    double **nodes;
+    double **weights;
+    uint32_t **ids;
+};
+struct NestedRule *nested_rule(enum QuadratureRules rule, unsigned int levels);
+void free_nested_rule(struct NestedRule *nr);
+
+short sparse(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    enum QuadratureRules rule, unsigned int maxlevel, uint64_t maxeval, double *res, double *err,
+    uint64_t *neval
+);
+
+#define DE_TMAX 4.5
+#define DE_MAX_LEVEL 16
+
+short tanhsinh(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    unsigned int maxlevel, double *res, double *err, uint64_t *neval
+);
+
+#define SOBOL_DIMENSIONS 32
+#define CBC_CANDIDATES 64
+
+enum QMCRules { SOBOL, HALTON, LATTICE };
+
+short qmc(
+    struct Function *f, struct Interval **intervals, unsigned int d, enum QMCRules rule, uint64_t n,
+    unsigned int nshifts, uint64_t seed, double *res, double *err
+);
+
+#define VEGAS_BINS 50
+#define VEGAS_ALPHA 1.5
+
+short vegas(
+    struct Function *f, struct Interval **intervals, unsigned int d, uint64_t neval, unsigned int niter,
+    uint64_t seed, unsigned int nthreads, double *res, double *err, double *chi2
+);
+
+short separable(struct Function **fs, unsigned int nterms, struct Grid *grid, double *res);
+
+#define SUM_CHUNK_MAX (1 << 20)
+#define SUM_BATCH 4
+#define SWEEP_CHUNK 16
+#define PROGRESSIVE_RATIO 0.6180339887498949
+
+short sweep(
+    struct Function *f, struct Grid *grid, double *params, Py_ssize_t P, unsigned int q,
+    unsigned int nthreads, double *res
+);
+
+short progressive(
+    struct Function *f, struct Grid *grid, double timeout, uint64_t maxeval, double *res, double *fraction
+);
+
+short tabulate(struct Function *f, struct Grid *grid, double *values);
+short cumulative(
+    struct Function *f, struct Grid *grid, struct Interval **intervals, enum RiemannRules *rrules,
+    const short *axes, unsigned int nthreads, double *res
 );
-short trapezoidal(PyObject *f, struct Interval **intervals, unsigned int d, double *res);
 
 typedef struct {
     PyObject_HEAD
@@ -37,6 +174,15 @@ typedef struct {
     unsigned int n;
 } IntervalObject;
 
+static int Interval_init(IntervalObject *self, PyObject *args, PyObject *kwds);
+
+static PyMemberDef IntervalMembers[] = {
+    {"lower", T_DOUBLE, offsetof(IntervalObject, lower), READONLY, NULL},
+    {"upper", T_DOUBLE, offsetof(IntervalObject, upper), READONLY, NULL},
+    {"n", T_UINT, offsetof(IntervalObject, n), READONLY, NULL},
+    {NULL}
+};
+
 static PyTypeObject IntervalType = {
     .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
     .tp_name = "integral.Interval",
@@ -45,6 +191,41 @@ static PyTypeObject IntervalType = {
     .tp_itemsize = 0,
     .tp_flags = Py_TPFLAGS_DEFAULT,
     .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)Interval_init,
+    .tp_members = IntervalMembers,
+};
+
+typedef struct {
+    PyObject_HEAD
+    struct Grid *grid;
+} PlanObject;
+
+static void Plan_dealloc(PlanObject *self);
+static int Plan_init(PlanObject *self, PyObject *args, PyObject *kwds);
+static PyObject *Plan_integrate(PlanObject *self, PyObject *args);
+static PyObject *Plan_integrate_many(PlanObject *self, PyObject *args);
+static PyObject *Plan_separable(PlanObject *self, PyObject *args);
+static PyObject *Plan_sweep(PlanObject *self, PyObject *args);
+
+static PyMethodDef PlanMethods[] = {
+    {"integrate", (PyCFunction)Plan_integrate, METH_VARARGS, NULL},
+    {"integrate_many", (PyCFunction)Plan_integrate_many, METH_VARARGS, NULL},
+    {"separable", (PyCFunction)Plan_separable, METH_VARARGS, NULL},
+    {"sweep", (PyCFunction)Plan_sweep, METH_VARARGS, NULL},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject PlanType = {
+    .ob_base = PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "integral.Plan",
+    .tp_doc = NULL,
+    .tp_basicsize = sizeof(PlanObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc)Plan_init,
+    .tp_dealloc = (destructor)Plan_dealloc,
+    .tp_methods = PlanMethods,
 };
 
 static PyObject *integral_delta(PyObject *self, PyObject *args);
@@ -56,6 +237,27 @@ static PyObject *integral_midpoint(PyObject *self, PyObject *args);
 
 static PyObject *integral_riemann(PyObject *self, PyObject *args);
 static PyObject *integral_trapezoidal(PyObject *self, PyObject *args);
+static PyObject *integral_quad(PyObject *self, PyObject *args);
+static PyObject *integral_romberg(PyObject *self, PyObject *args);
+static PyObject *integral_qmc(PyObject *self, PyObject *args);
+static PyObject *integral_vegas(PyObject *self, PyObject *args);
+static PyObject *integral_tensor(PyObject *self, PyObject *args);
+static PyObject *integral_sparse(PyObject *self, PyObject *args);
+static PyObject *integral_rule(PyObject *self, PyObject *args);
+static PyObject *integral_get_rule_cache(PyObject *self, PyObject *args);
+static PyObject *integral_set_rule_cache(PyObject *self, PyObject *args);
+static PyObject *integral_tanhsinh(PyObject *self, PyObject *args);
+static PyObject *integral_separable(PyObject *self, PyObject *args);
+static PyObject *integral_trapz(PyObject *self, PyObject *args);
+static PyObject *integral_simpson(PyObject *self, PyObject *args);
+static PyObject *integral_romb(PyObject *self, PyObject *args);
+static PyObject *integral_cumtrapz(PyObject *self, PyObject *args);
+static PyObject *integral_cumulative(PyObject *self, PyObject *args);
+static PyObject *integral_sweep(PyObject *self, PyObject *args);
+static PyObject *integral_progressive(PyObject *self, PyObject *args);
+
+static PyObject *integral_get_threads(PyObject *self, PyObject *args);
+static PyObject *integral_set_threads(PyObject *self, PyObject *args);
 
 static PyMethodDef IntegralMethods[] = {
     {"delta", integral_delta, METH_VARARGS, NULL},
@@ -65,6 +267,26 @@ static PyMethodDef IntegralMethods[] = {
     {"midpoint", integral_midpoint, METH_VARARGS, NULL},
     {"riemann", integral_riemann, METH_VARARGS, NULL},
     {"trapezoidal", integral_trapezoidal, METH_VARARGS, NULL},
+    {"quad", integral_quad, METH_VARARGS, NULL},
+    {"romberg", integral_romberg, METH_VARARGS, NULL},
+    {"qmc", integral_qmc, METH_VARARGS, NULL},
+    {"vegas", integral_vegas, METH_VARARGS, NULL},
+    {"tensor", integral_tensor, METH_VARARGS, NULL},
+    {"sparse", integral_sparse, METH_VARARGS, NULL},
+    {"rule", integral_rule, METH_VARARGS, NULL},
+    {"get_rule_cache", integral_get_rule_cache, METH_NOARGS, NULL},
+    {"set_rule_cache", integral_set_rule_cache, METH_VARARGS, NULL},
+    {"tanhsinh", integral_tanhsinh, METH_VARARGS, NULL},
+    {"separable", integral_separable, METH_VARARGS, NULL},
+    {"trapz", integral_trapz, METH_VARARGS, NULL},
+    {"simpson", integral_simpson, METH_VARARGS, NULL},
+    {"romb", integral_romb, METH_VARARGS, NULL},
+    {"cumtrapz", integral_cumtrapz, METH_VARARGS, NULL},
+    {"cumulative", integral_cumulative, METH_VARARGS, NULL},
+    {"sweep", integral_sweep, METH_VARARGS, NULL},
+    {"progressive", integral_progressive, METH_VARARGS, NULL},
+    {"get_threads", integral_get_threads, METH_NOARGS, NULL},
+    {"set_threads", integral_set_threads, METH_VARARGS, NULL},
     {NULL, NULL, 0, NULL}
 };
 
@@ -74,12 +296,16 @@ static PyModuleDef integral_module = {
 
 PyMODINIT_FUNC PyInit_integral() {
 
+    if (init_functions() == -1) { return NULL; }
+
     PyObject *m = PyModule_Create(&integral_module);
     if (!m) { return NULL; }
 
     if (
         PyType_Ready(&IntervalType) < 0
         || PyModule_AddObjectRef(m, "Interval", (PyObject *) &IntervalType) < 0
+        || PyType_Ready(&PlanType) < 0
+        || PyModule_AddObjectRef(m, "Plan", (PyObject *) &PlanType) < 0
     ) {
         Py_DECREF(m);
         return NULL;
@@ -88,6 +314,17 @@ PyMODINIT_FUNC PyInit_integral() {
         PyModule_AddIntConstant(m, "LEFT", LEFT) < 0
         || PyModule_AddIntConstant(m, "RIGHT", RIGHT) < 0
         || PyModule_AddIntConstant(m, "MIDPOINT", MIDPOINT) < 0
+        || PyModule_AddIntConstant(m, "GK15", GK15) < 0
+        || PyModule_AddIntConstant(m, "GK21", GK21) < 0
+        || PyModule_AddIntConstant(m, "SOBOL", SOBOL) < 0
+        || PyModule_AddIntConstant(m, "HALTON", HALTON) < 0
+        || PyModule_AddIntConstant(m, "LATTICE", LATTICE) < 0
+        || PyModule_AddIntConstant(m, "GAUSS_LEGENDRE", GAUSS_LEGENDRE) < 0
+        || PyModule_AddIntConstant(m, "GAUSS_LOBATTO", GAUSS_LOBATTO) < 0
+        || PyModule_AddIntConstant(m, "CLENSHAW_CURTIS", CLENSHAW_CURTIS) < 0
+        || PyModule_AddIntConstant(m, "GAUSS_PATTERSON", GAUSS_PATTERSON) < 0
+        || PyModule_AddIntConstant(m, "SIMPSON", SIMPSON) < 0
+        || PyModule_AddIntConstant(m, "TRAPEZOID", TRAPEZOID) < 0
     ) {
         Py_DECREF(m);
         return NULL;
@@ -0,0 +1,15 @@
+/**
+ * Parallel execution of independent tasks
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+
+#define MAX_THREADS 256
+
+typedef void (*Task)(void *context, unsigned int worker, size_t chunk);
+
+unsigned int get_threads(void);
+short set_threads(unsigned int nthreads);
+short parallel_for(unsigned int nthreads, size_t nchunks, Task task, void *context);
@@ -0,0 +1,27 @@
+/**
+ * Reproducible summation
+ */
+
+#include <stdint.h>
+
+
+#define LEAF_SIZE 256
+#define LANES 8
+#define MAX_LEVELS 64
+
+struct Compensated {
+    double sum;
+    double c;
+};
+
+struct Reducer {
+    double leaf[LEAF_SIZE];
+    unsigned int count;
+    uint64_t nleaves;
+    struct Compensated nodes[MAX_LEVELS];
+};
+
+void reducer_init(struct Reducer *r);
+void reducer_add(struct Reducer *r, double value);
+void reducer_merge(struct Reducer *r, const struct Reducer *s);
+double reducer_result(const struct Reducer *r);
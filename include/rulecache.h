@@ -0,0 +1,31 @@
+/**
+ * Persistent cache of quadrature rules
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <stdint.h>
+
+
+#define RULE_CACHE_MAGIC "PYNCRULE"
+#define RULE_CACHE_VERSION 1
+#define RULE_CACHE_PARAMS 2
+#define RULE_CACHE_MIN 256
+#define RULE_CACHE_ENV "PYNC_RULE_CACHE"
+
+typedef void (*RuleBuilder)(unsigned int n, double *x, double *w);
+
+struct RuleHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t family;
+    uint32_t n;
+    uint32_t reserved;
+    double params[RULE_CACHE_PARAMS];
+};
+
+const char *get_rule_cache(void);
+short set_rule_cache(const char *path);
+void load_rule(
+    unsigned int family, unsigned int n, const double *params, RuleBuilder build, double *x, double *w
+);
@@ -0,0 +1,22 @@
+/**
+ * Integration of tabulated samples
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+
+#define SAMPLE_LANES 4
+#define SCAN_BLOCK 4096
+
+enum SampleRule { SAMPLE_TRAPEZOID, SAMPLE_SIMPSON, SAMPLE_ROMBERG, SAMPLE_RECTANGLE };
+
+short sample_weights(enum SampleRule rule, Py_ssize_t n, double dx, const double *x, double *w);
+void reduce_axis(
+    const char *src, int ndim, const Py_ssize_t *shape, const Py_ssize_t *strides, int axis,
+    const double *w, double *dst
+);
+short cumulate_axis(
+    const char *src, int ndim, const Py_ssize_t *shape, const Py_ssize_t *strides, int axis,
+    enum SampleRule rule, double dx, const double *x, unsigned int nthreads, double *dst
+);
@@ -0,0 +1,24 @@
+/**
+ * Finite difference stencils
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+
+#define STENCIL_MAX_POINTS 32
+
+enum StencilRule { STENCIL_FORWARD, STENCIL_BACKWARD, STENCIL_CENTRAL };
+
+struct Stencil {
+    unsigned int order;
+    unsigned int accuracy;
+    enum StencilRule rule;
+    unsigned int n;
+    double *offsets;
+    double *weights;
+    struct Stencil *next;
+};
+
+void fornberg(unsigned int m, const double *z, unsigned int n, double *w);
+const struct Stencil *get_stencil(unsigned int order, unsigned int accuracy, enum StencilRule rule);
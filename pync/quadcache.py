@@ -0,0 +1,62 @@
+"""
+Pre-builds the persistent cache of quadrature rules used by :mod:`pync.integral`.
+
+Usage::
+
+    python -m pync.quadcache [--dir DIR] [--max N]
+
+Rules are written to ``DIR``, or to the default cache directory, which can be overridden by the
+``PYNC_RULE_CACHE`` environment variable. Rules smaller than the caching threshold are skipped, as
+they are always computed on demand.
+"""
+
+import argparse
+
+from . import integral
+
+
+#: The families of rules in the standard set
+FAMILIES = {
+    "gauss-legendre": integral.GAUSS_LEGENDRE,
+    "gauss-lobatto": integral.GAUSS_LOBATTO,
+    "clenshaw-curtis": integral.CLENSHAW_CURTIS,
+}
+
+#: The numbers of nodes in the standard set
+SIZES = (256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192)
+
+
+def build(families=FAMILIES.values(), sizes=SIZES):
+    """
+    Computes each rule of ``families`` with each number of nodes in ``sizes`` through the cache,
+    returning the number of rules visited.
+    """
+    count = 0
+    for family in families:
+        for n in sizes:
+            integral.rule(family, n)
+            count += 1
+    return count
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(prog="python -m pync.quadcache", description=__doc__.split("\n\n")[0])
+    parser.add_argument("--dir", help="the cache directory")
+    parser.add_argument("--max", type=int, default=SIZES[-1], help="the largest number of nodes to build")
+    parser.add_argument(
+        "--family", action="append", choices=sorted(FAMILIES), help="a family of rules to build, repeatable"
+    )
+    args = parser.parse_args(argv)
+
+    if args.dir:
+        integral.set_rule_cache(args.dir)
+    if integral.get_rule_cache() is None:
+        parser.error("the rule cache is disabled")
+
+    families = [FAMILIES[name] for name in args.family] if args.family else FAMILIES.values()
+    count = build(families, [n for n in SIZES if n <= args.max])
+    print(f"{count} rules cached in {integral.get_rule_cache()}")
+
+
+if __name__ == "__main__":
+    main()
@@ -2,11 +2,13 @@
  * Source file for "../include/differential.h"
  */
 
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "../include/differential.h"
 #include "../include/functions.h"
-#include "../include/numbers.h"
+#include "../include/stencils.h"
 
 
 /**
@@ -19,7 +21,7 @@
 static double *duplicate(double *x, unsigned int d) {
     double *y = (double *)calloc(d, sizeof(double));
     if (!y) { return NULL; }
-    for (int i = 0; i < d; ++i) { *(y + i) = *(x + 1); }
+    for (unsigned int i = 0; i < d; ++i) { *(y + i) = *(x + i); }
     return y;
 }
 
@@ -33,7 +35,7 @@ static double *duplicate(double *x, unsigned int d) {
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *forward_first(PyObject *f, double *x, double h, unsigned int d) {
+static double *forward_first(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *finite_differences = (double *)calloc(d, sizeof(double));
@@ -42,10 +44,10 @@ static double *forward_first(PyObject *f, double *x, double h, unsigned int d) {
         return NULL;
     }
 
-    double a, b;
+    const double fx = eval(f, x, d);
     for (int i = 0; i < d; ++i) {
         *(x1 + i) += h;
-        *(finite_differences + i) = eval(f, x1, d) - eval(f, x, d);
+        *(finite_differences + i) = eval(f, x1, d) - fx;
         *(x1 + i) -= h;
     }
 
@@ -65,7 +67,7 @@ static double *forward_first(PyObject *f, double *x, double h, unsigned int d) {
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *forward_second(PyObject *f, double *x, double h, unsigned int d) {
+static double *forward_second(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *x2 = duplicate(x, d);
@@ -75,10 +77,11 @@ static double *forward_second(PyObject *f, double *x, double h, unsigned int d)
         return NULL;
     }
 
+    const double fx = eval(f, x, d);
     for (int i = 0; i < d; ++i) {
 
         *(x1 + i) += 2 * h, *(x2 + i) += h;
-        *(finite_differences + i) = eval(f, x1, d) - 2 * eval(f, x2, d) + eval(f, x, d);
+        *(finite_differences + i) = eval(f, x1, d) - 2 * eval(f, x2, d) + fx;
         *(x1 + i) -= 2 * h, *(x2 + i) -= h;
     }
 
@@ -88,44 +91,6 @@ static double *forward_second(PyObject *f, double *x, double h, unsigned int d)
 
 }
 
-/**
- * Computes the nth-order forward partial finite differences for a mathematical function of several
- * real variables at a specified domain element using a given step size.
- * 
- * @param f A callable representation of a mathematical function of several real variables
- * @param x The domain element of `f` at which to compuate the finite differences
- * @param h The step size to use in computing the finite differences
- * @param n The degree of the finite differences
- * @param d The number of dimensions in the domai of `f`
- * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
- */
-static double *forward_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d) {
-
-    double *x1 = duplicate(x, d);
-    double *finite_differences = (double *)calloc(d, sizeof(double));
-    if (!x1 || !finite_differences) {
-        free(x1); free(finite_differences);
-        return NULL;
-    }
-
-    for (int i = 0; i < d; ++i) {
-
-        *(finite_differences + i) = 0.;
-
-        for (int k = 0; k <= n; ++k) {
-            *(x1 + i) += k * h;
-            *(finite_differences + i) += (n - k % 2 == 0 ? 1 : -1) * binom(n, k) * eval(f, x1, d);
-            *(x1 + i) -= k * h;
-        }
-
-    }
-
-    free(x1);
-
-    return finite_differences;
-
-}
-
 /**
  * Computes the first-order backward partial finite differences for a mathematical function of several
  * real variables at a specified domain element using a given step size.
@@ -136,7 +101,7 @@ static double *forward_nth(PyObject *f, double *x, double h, unsigned int n, uns
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *backward_first(PyObject *f, double *x, double h, unsigned int d) {
+static double *backward_first(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *finite_differences = (double *)calloc(d, sizeof(double));
@@ -145,9 +110,10 @@ static double *backward_first(PyObject *f, double *x, double h, unsigned int d)
         return NULL;
     }
 
+    const double fx = eval(f, x, d);
     for (int i = 0; i < d; ++i) {
         *(x1 + i) -= h;
-        *(finite_differences + i) = eval(f, x, d) - eval(f, x1, d);
+        *(finite_differences + i) = fx - eval(f, x1, d);
         *(x1 + i) += h;
     }
 
@@ -167,7 +133,7 @@ static double *backward_first(PyObject *f, double *x, double h, unsigned int d)
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *backward_second(PyObject *f, double *x, double h, unsigned int d) {
+static double *backward_second(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *x2 = duplicate(x, d);
@@ -177,9 +143,10 @@ static double *backward_second(PyObject *f, double *x, double h, unsigned int d)
         return NULL;
     }
 
+    const double fx = eval(f, x, d);
     for (int i = 0; i < d; ++i) {
         *(x1 + i) -= h, *(x2 + i) -= 2 * h;
-        *(finite_differences + i) = eval(f, x, d) - 2 * eval(f, x1, d) + eval(f, x2, d);
+        *(finite_differences + i) = fx - 2 * eval(f, x1, d) + eval(f, x2, d);
         *(x1 + i) += h, *(x2 + i) += 2 * h;
     }
 
@@ -189,44 +156,6 @@ static double *backward_second(PyObject *f, double *x, double h, unsigned int d)
 
 }
 
-/**
- * Computes the nth-order backward partial finite differences of a mathematical function of several
- * real variables at a specified domain element using a given step size.
- * 
- * @param f A callable representation of a mathematical function of several real variables
- * @param x The domain element of `f` at which to compute the finite differences
- * @param h The step size to use in computing the finite differences
- * @param n The degree of the finite differences
- * @param d The number of dimensions in the domain of `f`
- * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
- */
-static double *backward_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d) {
-
-    double *x1 = duplicate(x, d);
-    double *finite_differences = (double *)calloc(d, sizeof(double));
-    if (!x1 || !finite_differences) {
-        free(x1); free(finite_differences);
-        return NULL;
-    }
-
-    for (int i = 0; i < d; ++i) {
-
-        *(finite_differences + i) = 0.;
-
-        for (int k = 0; k <= n; ++i) {
-            *(x1 + i) -= k * h;
-            *(finite_differences + i) += (i % 2 == 0 ? 1 : -1) * binom(n, k) * eval(f, x1, d);
-            *(x1 + i) += k * h;
-        }
-
-    }
-
-    free(x1);
-
-    return finite_differences;
-
-}
-
 /**
  * Computes the first-order central partial finite differences for a mathematical function of several
  * real variables at a specified domain element using a given step size.
@@ -237,7 +166,7 @@ static double *backward_nth(PyObject *f, double *x, double h, unsigned int n, un
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *central_first(PyObject *f, double *x, double h, unsigned int d) {
+static double *central_first(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *x2 = duplicate(x, d);
@@ -271,7 +200,7 @@ static double *central_first(PyObject *f, double *x, double h, unsigned int d) {
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *central_second(PyObject *f, double *x, double h, unsigned int d) {
+static double *central_second(struct Function *f, double *x, double h, unsigned int d) {
 
     double *x1 = duplicate(x, d);
     double *x2 = duplicate(x, d);
@@ -281,10 +210,11 @@ static double *central_second(PyObject *f, double *x, double h, unsigned int d)
         return NULL;
     }
 
+    const double fx = eval(f, x, d);
     for (int i = 0; i < d; ++i) {
 
         *(x1 + i) += h, *(x2 + i) -= h;
-        *(finite_differences + i) = eval(f, x1, d) - 2 * eval(f, x, d) + eval(f, x2, d);
+        *(finite_differences + i) = eval(f, x1, d) - 2 * fx + eval(f, x2, d);
         *(x1 + i) -= h, *(x2 + i) += h;
 
     }
@@ -296,17 +226,20 @@ static double *central_second(PyObject *f, double *x, double h, unsigned int d)
 }
 
 /**
- * Computes the nth-order central partial finite differences for a mathematical function fo several
- * real variables at a specified domain element using a given step size.
- * 
- * @param f A mathematical function of several real variables
+ * Computes the partial finite differences of a mathematical function of several real variables at a
+ * specified domain element using a given step size and finite difference stencil. Offsets of zero
+ * weight are not evaluated.
+ *
+ * @param f A callable representation of a mathematical function of several real variables
  * @param x The domain element of `f` at which to compute the finite differences
  * @param h The step size to use in computing the finite differences
- * @param n The order of the finite differences
+ * @param stencil The offsets, in steps, and weights of the finite differences
  * @param d The number of dimensions in the domain of `f`
  * @return A dynamically allocated array of the computed finite differences, or `NULL` upon failure
  */
-static double *central_nth(PyObject *f, double *x, double h, unsigned int n, unsigned int d) {
+static double *stencil_differences(
+    struct Function *f, double *x, double h, const struct Stencil *stencil, unsigned int d
+) {
 
     double *x1 = duplicate(x, d);
     double *finite_differences = (double *)calloc(d, sizeof(double));
@@ -315,17 +248,16 @@ static double *central_nth(PyObject *f, double *x, double h, unsigned int n, uns
         return NULL;
     }
 
-    for (int i = 0; i < d; ++i) {
-
-        *(finite_differences + i) = 0.;
-
-        for (int k = 0; k <= n; ++i) {
-
-            *(x1 + i) += (n / 2 - k) * h;
-            *(finite_differences + i) += (i % 2 == 0 ? 1 : -1) * binom(n, k) * eval(f, x1, d);
-            *(x1 + i) -= (n / 2 - k) * h;
+    for (unsigned int i = 0; i < d; ++i) {
 
+        double sum = 0.;
+        for (unsigned int k = 0; k < stencil->n; ++k) {
+            if (*(stencil->weights + k) == 0.) { continue; }
+            *(x1 + i) = *(x + i) + *(stencil->offsets + k) * h;
+            sum += *(stencil->weights + k) * eval(f, x1, d);
         }
+        *(x1 + i) = *(x + i);
+        *(finite_differences + i) = sum;
 
     }
 
@@ -337,7 +269,8 @@ static double *central_nth(PyObject *f, double *x, double h, unsigned int n, uns
 
 /**
  * Computes the nth-order partial difference quotients for a mathematical function of several real
- * variables at a specified domain element using a given step size.
+ * variables at a specified domain element using a given step size. The first- and second-order rules
+ * evaluate `f` at `x` once for all axes.
  * 
  * @param f A callable representation of a mathematical function of several real variables
  * @param x The domain element of `f` at which to compute the difference quotients
@@ -345,59 +278,455 @@ static double *central_nth(PyObject *f, double *x, double h, unsigned int n, uns
  * @param n The order of the difference quotients
  * @param d The number of dimensions in the domain of `f`
  * @param rule Specifies the type of finite difference to use in computing the difference quotients
+ * @param stencil The finite difference stencil to use, or `NULL` for the first- and second-order rules
  * @return A dyanmically allocated array of the computed difference quotients, or `NULL` upon failure
  */
 static double *dquotient(
-    PyObject *f, double *x, double h, unsigned int n, unsigned int d, enum FinDiffRule rule
+    struct Function *f, double *x, double h, unsigned int n, unsigned int d, enum FinDiffRule rule,
+    const struct Stencil *stencil
+) {
+
+    struct FiniteDifference *const findiffs[] = { &forward, &backward, &central };
+    struct FiniteDifference *findiff = findiffs[rule];
+
+    double *finite_differences;
+    if (stencil) {
+        finite_differences = stencil_differences(f, x, h, stencil, d);
+    } else if (n == 1) {
+        finite_differences = findiff->first(f, x, h, d);
+    } else {
+        finite_differences = findiff->second(f, x, h, d);
+    }
+    if (!finite_differences) { return NULL; }
+
+    double step = pow(h, n);
+    for (unsigned int i = 0; i < d; ++i) { *(finite_differences + i) /= step; }
+
+    return finite_differences;
+
+}
+
+/**
+ * Computes the nth-order partial derivatives of a mathematical function of several real variables at a
+ * specified domain element by Ridders' extrapolation of difference quotients of decreasing step sizes,
+ * along with estimates of their errors.
+ *
+ * Along each axis, difference quotients are computed with the step sizes `h`, `h / 2`, `h / 4`, ... and
+ * extrapolated to zero step size in a Neville tableau, eliminating the terms of the error of the
+ * stencil in increasing order. Halving the step size makes the even offsets of the stencil coincide
+ * with offsets of the previous step size, whose values are reused. The extrapolation stops once the
+ * diagonal of the tableau departs from the best estimate by more than `RIDDERS_SAFE` times its error.
+ * Python callables must be called with the GIL held; native functions need not be.
+ *
+ * @param f A callable representation of a mathematical function of several real variables
+ * @param x The domain element of `f` at which to compute the derivatives
+ * @param h The initial step size, which should be large
+ * @param d The number of dimensions in the domain of `f`
+ * @param stencil The finite difference stencil to extrapolate
+ * @param res The location to which to write the `d` derivatives
+ * @param err The location to which to write the `d` error estimates
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short ridders(
+    struct Function *f, double *x, double h, unsigned int d, const struct Stencil *stencil, double *res,
+    double *err
 ) {
 
-    struct FiniteDifference *findiff;
+    const unsigned int m = stencil->n;
+    const double first = *stencil->offsets;
+    const double leading = pow(2., stencil->accuracy);
+    const double spacing = stencil->rule == STENCIL_CENTRAL ? 4. : 2.;
+
+    double *x1 = duplicate(x, d);
+    double *values = (double *)malloc(2 * m * sizeof(double));
+    short *known = (short *)calloc(2 * m, sizeof(short));
+    if (!x1 || !values || !known) {
+        free(x1); free(values); free(known);
+        return -1;
+    }
+
+    double a[RIDDERS_LEVELS][RIDDERS_LEVELS];
+    for (unsigned int i = 0; i < d; ++i) {
+
+        double *prev = values, *curr = values + m;
+        short *prev_known = known, *curr_known = known + m;
+        double step = h;
+        *(err + i) = INFINITY;
+
+        for (unsigned int level = 0; level < RIDDERS_LEVELS; ++level, step /= 2) {
+
+            double sum = 0.;
+            for (unsigned int k = 0; k < m; ++k) {
+                const double offset = *(stencil->offsets + k), j = offset / 2 - first;
+                *(curr_known + k) = 0;
+                if (*(stencil->weights + k) == 0.) { continue; }
+                if (level && j == floor(j) && j < m && *(prev_known + (unsigned int)j)) {
+                    *(curr + k) = *(prev + (unsigned int)j);
+                } else {
+                    *(x1 + i) = *(x + i) + offset * step;
+                    *(curr + k) = eval(f, x1, d);
+                    if (f->type != NATIVE && PyErr_Occurred()) {
+                        free(x1); free(values); free(known);
+                        return -1;
+                    }
+                }
+                *(curr_known + k) = 1;
+                sum += *(stencil->weights + k) * *(curr + k);
+            }
+            *(x1 + i) = *(x + i);
+
+            a[0][level] = sum / pow(step, stencil->order);
+            if (!level) { *(res + i) = a[0][0]; }
+
+            double fac = leading;
+            for (unsigned int j = 1; j <= level; ++j, fac *= spacing) {
+                a[j][level] = (a[j - 1][level] * fac - a[j - 1][level - 1]) / (fac - 1);
+                const double e1 = fabs(a[j][level] - a[j - 1][level]);
+                const double e2 = fabs(a[j][level] - a[j - 1][level - 1]);
+                const double e = e1 > e2 ? e1 : e2;
+                if (e <= *(err + i)) { *(err + i) = e, *(res + i) = a[j][level]; }
+            }
+            if (level && fabs(a[level][level] - a[level - 1][level - 1]) >= RIDDERS_SAFE * *(err + i)) {
+                break;
+            }
+
+            double *swap = prev;
+            prev = curr, curr = swap;
+            short *swap_known = prev_known;
+            prev_known = curr_known, curr_known = swap_known;
+
+        }
+
+    }
+
+    free(x1); free(values); free(known);
+
+    return 0;
+
+}
+
+/**
+ * Computes the first-order partial derivatives of a real-valued analytic function of several real
+ * variables at each of a batch of domain elements by the complex-step method, as the imaginary parts of
+ * the values of its analytic extension at steps of `i * h` along each axis, divided by `h`.
+ *
+ * The derivatives involve no subtraction, so `h` may be taken far below the square root of the machine
+ * epsilon and the derivatives are accurate to machine precision, with `d` evaluations per domain
+ * element. The steps of consecutive domain elements are evaluated together in blocks of `f->blocksize`.
+ *
+ * @param f A representation of a mathematical function of several complex variables
+ * @param x The row-major array of `N` real domain elements at which to compute the derivatives
+ * @param N The number of domain elements
+ * @param d The number of dimensions in the domain of `f`
+ * @param h The step size
+ * @param res The location to which to write the row-major array of `N` gradients
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short complex_step(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, double *res
+) {
+
+    const Py_ssize_t B = f->blocksize, rows = N * (Py_ssize_t)d;
+    const Py_ssize_t cap = rows && rows < B ? rows : B;
+
+    double *block = (double *)malloc(2 * cap * d * sizeof(double));
+    double *values = (double *)malloc(2 * cap * sizeof(double));
+    if (!block || !values) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(values);
+        return -1;
+    }
+
+    for (Py_ssize_t r = 0; r < rows; r += B) {
+
+        const Py_ssize_t M = rows - r < B ? rows - r : B;
+        for (Py_ssize_t s = 0; s < M; ++s) {
+            const double *point = x + (r + s) / d * d;
+            double *z = block + 2 * s * d;
+            for (unsigned int k = 0; k < d; ++k) { *(z + 2 * k) = *(point + k), *(z + 2 * k + 1) = 0.; }
+            *(z + 2 * ((r + s) % d) + 1) = h;
+        }
+
+        if (eval_complex(f, block, M, d, values) == -1) {
+            free(block); free(values);
+            return -1;
+        }
+        for (Py_ssize_t s = 0; s < M; ++s) { *(res + r + s) = *(values + 2 * s + 1) / h; }
+
+    }
+
+    free(block); free(values);
+
+    return 0;
+
+}
+
+/**
+ * Writes a row of the first-order finite difference stencil of a domain element.
+ *
+ * The stencil of the forward and backward rules consists of the domain element followed by its shifts
+ * by `h` along each axis; that of the central rule consists of the shifts by `h / 2` along each axis,
+ * followed by the shifts by `-h / 2`.
+ *
+ * @param x The domain element
+ * @param d The number of dimensions of the domain element
+ * @param h The step size
+ * @param rule The type of finite difference
+ * @param k The index of the row in the stencil
+ * @param row The location to which to write the row
+ */
+static void stencil_row(
+    const double *x, unsigned int d, double h, enum FinDiffRule rule, Py_ssize_t k, double *row
+) {
+
+    memcpy(row, x, d * sizeof(double));
     switch (rule) {
         case FORWARD:
-            findiff = &forward;
+            if (k) { *(row + k - 1) += h; }
             break;
         case BACKWARD:
-            findiff = &backward;
+            if (k) { *(row + k - 1) -= h; }
             break;
         case CENTRAL:
-            findiff = &central;
+            if (k < d) { *(row + k) += h / 2; } else { *(row + k - d) -= h / 2; }
             break;
     }
 
-    double *finite_differences;
-    switch(n) {
-        case 1:
-            finite_differences = findiff->first(f, x, h, d);
-            break;
-        case 2:
-            finite_differences = findiff->second(f, x, h, d);
-            break;
-        default:
-            finite_differences = findiff->nth(f, x, h, n, d);
-            break;
+}
+
+/**
+ * Writes a row of the second-order finite difference stencil of a domain element.
+ *
+ * The stencil consists of the domain element, its shifts by `s * h` along each axis, its shifts by
+ * `2 * s * h` along each axis, and its shifts by `s * h` along each pair of axes `i < j`, where `s` is
+ * `-1` for the backward rule and `1` otherwise. The central rule instead uses the shifts by `-h` along
+ * each axis, and adds the shift by `-h` along each pair of axes after the shift by `h`.
+ *
+ * @param x The domain element
+ * @param d The number of dimensions of the domain element
+ * @param h The step size
+ * @param rule The type of finite difference
+ * @param k The index of the row in the stencil
+ * @param row The location to which to write the row
+ */
+static void hessian_row(
+    const double *x, unsigned int d, double h, enum FinDiffRule rule, Py_ssize_t k, double *row
+) {
+
+    const double step = rule == BACKWARD ? -h : h;
+
+    memcpy(row, x, d * sizeof(double));
+    if (!k) { return; }
+    if (k <= d) {
+        *(row + k - 1) += step;
+        return;
+    }
+    if (k <= 2 * (Py_ssize_t)d) {
+        *(row + k - d - 1) += rule == CENTRAL ? -h : 2 * step;
+        return;
     }
-    if (!finite_differences) { return NULL; }
 
-    double step = power(h, n);
-    for (int i = 0; i < d; ++i) { *(finite_differences + i) /= step; }
+    Py_ssize_t pair = k - 2 * (Py_ssize_t)d - 1;
+    double shift = step;
+    if (rule == CENTRAL) {
+        shift = pair % 2 ? -h : h;
+        pair /= 2;
+    }
+    unsigned int i = 0;
+    for (; pair >= d - i - 1; ++i) { pair -= d - i - 1; }
+    *(row + i) += shift, *(row + i + 1 + pair) += shift;
 
-    return finite_differences;
+}
+
+/**
+ * Evaluates a mathematical function of several real variables at the stencils of consecutive domain
+ * elements, in blocks of at most `f->blocksize` domain elements.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x The row-major array of `count` domain elements
+ * @param count The number of domain elements
+ * @param d The number of dimensions in the domain of `f`
+ * @param h The step size
+ * @param rule The type of finite difference
+ * @param row The function writing the rows of the stencil of a domain element
+ * @param stencil The number of rows in the stencil of a domain element
+ * @param block A buffer of `min(f->blocksize, count * stencil) * d` values
+ * @param values The location to which to write the `count * stencil * f->outputs` values of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short eval_stencils(
+    struct Function *f, const double *x, Py_ssize_t count, unsigned int d, double h, enum FinDiffRule rule,
+    StencilRow row, Py_ssize_t stencil, double *block, double *values
+) {
+
+    const Py_ssize_t B = f->blocksize, rows = count * stencil;
+
+    for (Py_ssize_t r = 0; r < rows; r += B) {
+        const Py_ssize_t M = rows - r < B ? rows - r : B;
+        for (Py_ssize_t s = 0; s < M; ++s) {
+            row(x + (r + s) / stencil * d, d, h, rule, (r + s) % stencil, block + s * d);
+        }
+        if (eval_block(f, block, M, d, values + r * f->outputs) == -1) { return -1; }
+    }
+
+    return 0;
 
 }
 
 /**
- * Python API wrapper for `dquotient`
+ * Computes the first-order partial difference quotients of a mathematical function of several real
+ * variables at each of a batch of domain elements using a given step size.
+ *
+ * The stencils of consecutive domain elements are evaluated together in blocks of `f->blocksize` domain
+ * elements, and the forward and backward rules evaluate `f` only once at each domain element of the
+ * batch, so that `d + 1` evaluations are needed per domain element, or `2 * d` for the central rule.
+ * Functions with `f->outputs` values yield a Jacobian matrix of `f->outputs` rows per domain element.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x The row-major array of `N` domain elements at which to compute the difference quotients
+ * @param N The number of domain elements
+ * @param d The number of dimensions in the domain of `f`
+ * @param h The step size to use in computing the difference quotients
+ * @param rule Specifies the type of finite difference to use in computing the difference quotients
+ * @param res The location to which to write the row-major array of `N` gradients or Jacobian matrices
+ * @return `0` upon success, or `-1` upon failure
  */
-static PyObject *differential_dquotient(PyObject *self, PyObject *args) {
+static short gradient(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, enum FinDiffRule rule, double *res
+) {
 
-    PyObject *ob_f;
-    PyObject *ob_x;
-    double h;
-    unsigned int n;
-    enum FinDiffRule rule;
-    if (!PyArg_ParseTuple(args, "OOdIi", &ob_f, &ob_x, &h, &n, &rule)) { return NULL; }
+    const unsigned int m = f->outputs;
+    const Py_ssize_t stencil = rule == CENTRAL ? 2 * (Py_ssize_t)d : (Py_ssize_t)d + 1;
+    const Py_ssize_t chunk = f->blocksize > stencil ? f->blocksize / stencil : 1;
+    const Py_ssize_t rows = chunk * stencil < f->blocksize ? chunk * stencil : f->blocksize;
+
+    double *block = (double *)malloc(rows * d * sizeof(double));
+    double *values = (double *)malloc(chunk * stencil * m * sizeof(double));
+    if (!block || !values) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(values);
+        return -1;
+    }
 
-    PyObject *f = parse_function(ob_f);
+    for (Py_ssize_t first = 0; first < N; first += chunk) {
+
+        const Py_ssize_t count = N - first < chunk ? N - first : chunk;
+        if (eval_stencils(f, x + first * d, count, d, h, rule, stencil_row, stencil, block, values) == -1) {
+            free(block); free(values);
+            return -1;
+        }
+
+        for (Py_ssize_t j = 0; j < count; ++j) {
+            for (unsigned int l = 0; l < m; ++l) {
+                const double *y = values + j * stencil * m + l;
+                double *g = res + ((first + j) * m + l) * d;
+                for (unsigned int i = 0; i < d; ++i) {
+                    switch (rule) {
+                        case FORWARD:
+                            *(g + i) = (*(y + (i + 1) * m) - *y) / h;
+                            break;
+                        case BACKWARD:
+                            *(g + i) = (*y - *(y + (i + 1) * m)) / h;
+                            break;
+                        case CENTRAL:
+                            *(g + i) = (*(y + i * m) - *(y + (d + i) * m)) / h;
+                            break;
+                    }
+                }
+            }
+        }
+
+    }
+
+    free(block); free(values);
+
+    return 0;
+
+}
+
+/**
+ * Computes the second-order partial difference quotients, pure and mixed, of a mathematical function of
+ * several real variables at each of a batch of domain elements using a given step size.
+ *
+ * The pure and mixed quotients share the evaluations at the domain element and at its shifts along each
+ * axis, so that `1 + 2 * d + d * (d - 1) / 2` evaluations are needed per domain element, or
+ * `1 + 2 * d + d * (d - 1)` for the central rule, whose mixed quotients are accurate to second order.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x The row-major array of `N` domain elements at which to compute the difference quotients
+ * @param N The number of domain elements
+ * @param d The number of dimensions in the domain of `f`
+ * @param h The step size to use in computing the difference quotients
+ * @param rule Specifies the type of finite difference to use in computing the difference quotients
+ * @param res The location to which to write the row-major array of `N` symmetric `d` by `d` matrices
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short hessian(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double h, enum FinDiffRule rule, double *res
+) {
+
+    const Py_ssize_t pairs = (Py_ssize_t)d * (d - 1) / 2;
+    const Py_ssize_t stencil = 1 + 2 * (Py_ssize_t)d + (rule == CENTRAL ? 2 : 1) * pairs;
+    const Py_ssize_t chunk = f->blocksize > stencil ? f->blocksize / stencil : 1;
+    const Py_ssize_t rows = chunk * stencil < f->blocksize ? chunk * stencil : f->blocksize;
+    const double h2 = h * h;
+
+    double *block = (double *)malloc(rows * d * sizeof(double));
+    double *values = (double *)malloc(chunk * stencil * sizeof(double));
+    if (!block || !values) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(values);
+        return -1;
+    }
+
+    for (Py_ssize_t first = 0; first < N; first += chunk) {
+
+        const Py_ssize_t count = N - first < chunk ? N - first : chunk;
+        if (eval_stencils(f, x + first * d, count, d, h, rule, hessian_row, stencil, block, values) == -1) {
+            free(block); free(values);
+            return -1;
+        }
+
+        for (Py_ssize_t j = 0; j < count; ++j) {
+
+            const double *y = values + j * stencil, *p = y + 1, *q = y + 1 + d, *pq = y + 1 + 2 * d;
+            double *H = res + (first + j) * d * d;
+
+            for (unsigned int i = 0; i < d; ++i) {
+                *(H + i * d + i) = (
+                    rule == CENTRAL ? *(p + i) - 2 * *y + *(q + i) : *(q + i) - 2 * *(p + i) + *y
+                ) / h2;
+            }
+            for (unsigned int i = 0, k = 0; i < d; ++i) {
+                for (unsigned int l = i + 1; l < d; ++l, ++k) {
+                    const double value = rule == CENTRAL
+                        ? (
+                            *(pq + 2 * k) + *(pq + 2 * k + 1) + 2 * *y
+                            - *(p + i) - *(p + l) - *(q + i) - *(q + l)
+                        ) / (2 * h2)
+                        : (*(pq + k) - *(p + i) - *(p + l) + *y) / h2;
+                    *(H + i * d + l) = *(H + l * d + i) = value;
+                }
+            }
+
+        }
+
+    }
+
+    free(block); free(values);
+
+    return 0;
+
+}
+
+/**
+ * Parses a domain element given as a sequence of 'float' objects.
+ *
+ * @param ob_x The domain element
+ * @param d The location to which to write the number of dimensions of the domain element
+ * @return A dynamically allocated array holding the domain element, or `NULL` upon failure
+ */
+static double *parse_point(PyObject *ob_x, unsigned int *d) {
 
     if (!PySequence_Check(ob_x)) {
         PyErr_SetString(PyExc_TypeError, "Expected a sequence of 'float' objects");
@@ -409,19 +738,18 @@ static PyObject *differential_dquotient(PyObject *self, PyObject *args) {
         PyErr_SetString(PyExc_RuntimeError, "Failed to determine sequence length");
         return NULL;
     }
-    unsigned int d = (unsigned int)size_x;
+    *d = (unsigned int)size_x;
 
     double *x;
-    if (!(x = (double *)calloc(d, sizeof(double)))) {
+    if (!(x = (double *)calloc(*d ? *d : 1, sizeof(double)))) {
         PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
         return NULL;
     }
 
-    for (unsigned int i = 0; i < d; ++i) {
+    for (unsigned int i = 0; i < *d; ++i) {
         PyObject *item;
         if (!(item = PySequence_GetItem(ob_x, i))) {
             PyErr_SetString(PyExc_TypeError, "Expected a sequence of 'float' objects");
-            Py_XDECREF(item);
             free(x);
             return NULL;
         }
@@ -435,30 +763,320 @@ static PyObject *differential_dquotient(PyObject *self, PyObject *args) {
         Py_DECREF(item);
     }
 
-    double *res = dquotient(f, x, h, n, d, rule);
+    return x;
+
+}
+
+/**
+ * Packs an array of values into a tuple of 'float' objects.
+ *
+ * @param values The values
+ * @param d The number of values
+ * @return A tuple of 'float' objects, or `NULL` upon failure
+ */
+static PyObject *pack_tuple(const double *values, unsigned int d) {
+
+    PyObject *tuple = PyTuple_New(d);
+    if (!tuple) { return NULL; }
+
+    for (unsigned int i = 0; i < d; ++i) {
+        PyObject *item = PyFloat_FromDouble(*(values + i));
+        if (!item) {
+            Py_DECREF(tuple);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(tuple, i, item);
+    }
+
+    return tuple;
+
+}
+
+/**
+ * Python API wrapper for `dquotient`
+ */
+static PyObject *differential_dquotient(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_x;
+    double h;
+    unsigned int n;
+    enum FinDiffRule rule;
+    unsigned int accuracy = 0;
+    if (!PyArg_ParseTuple(args, "OOdIi|I", &ob_f, &ob_x, &h, &n, &rule, &accuracy)) { return NULL; }
+    if (rule != FORWARD && rule != BACKWARD && rule != CENTRAL) {
+        PyErr_SetString(PyExc_ValueError, "Expected a finite difference rule");
+        return NULL;
+    }
+    if (n < 1) {
+        PyErr_SetString(PyExc_ValueError, "Expected a positive order of differentiation");
+        return NULL;
+    }
+
+    const struct Stencil *stencil = NULL;
+    if ((n > 2 || accuracy) && !(stencil = get_stencil(n, accuracy, (enum StencilRule)rule))) {
+        return NULL;
+    }
+
+    unsigned int d;
+    struct Function *f = parse_function(ob_f, 0);
+    double *x = f ? parse_point(ob_x, &d) : NULL;
+    if (!x) {
+        free_function(f);
+        return NULL;
+    }
+
+    double *res;
+    if (f->type == NATIVE) {
+        Py_BEGIN_ALLOW_THREADS
+        res = dquotient(f, x, h, n, d, rule, stencil);
+        Py_END_ALLOW_THREADS
+    } else {
+        res = dquotient(f, x, h, n, d, rule, stencil);
+    }
+    if (!res || PyErr_Occurred()) {
+        if (!res) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        free_function(f); free(x); free(res);
+        return NULL;
+    }
+
+    PyObject *tuple = pack_tuple(res, d);
+    free_function(f); free(x); free(res);
+
+    return tuple;
+
+}
+
+/**
+ * Python API wrapper for `ridders`
+ */
+static PyObject *differential_ridders(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_x;
+    double h;
+    unsigned int n;
+    enum FinDiffRule rule;
+    unsigned int accuracy = 0;
+    if (!PyArg_ParseTuple(args, "OOdIi|I", &ob_f, &ob_x, &h, &n, &rule, &accuracy)) { return NULL; }
+    if (rule != FORWARD && rule != BACKWARD && rule != CENTRAL) {
+        PyErr_SetString(PyExc_ValueError, "Expected a finite difference rule");
+        return NULL;
+    }
+    if (n < 1) {
+        PyErr_SetString(PyExc_ValueError, "Expected a positive order of differentiation");
+        return NULL;
+    }
+
+    const struct Stencil *stencil = get_stencil(n, accuracy, (enum StencilRule)rule);
+    if (!stencil) { return NULL; }
+
+    unsigned int d;
+    struct Function *f = parse_function(ob_f, 0);
+    double *x = f ? parse_point(ob_x, &d) : NULL;
+    double *res = x ? (double *)calloc(2 * (d ? d : 1), sizeof(double)) : NULL;
     if (!res) {
+        if (x) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        free_function(f); free(x);
+        return NULL;
+    }
+
+    short status;
+    if (f->type == NATIVE) {
+        Py_BEGIN_ALLOW_THREADS
+        status = ridders(f, x, h, d, stencil, res, res + d);
+        Py_END_ALLOW_THREADS
+    } else {
+        status = ridders(f, x, h, d, stencil, res, res + d);
+    }
+    if (status == -1 && !PyErr_Occurred()) {
         PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
-        free(x); free(res);
+    }
+
+    PyObject *value = status ? NULL : Py_BuildValue("(NN)", pack_tuple(res, d), pack_tuple(res + d, d));
+    free_function(f); free(x); free(res);
+
+    return value;
+
+}
+
+/**
+ * Parses a batch of domain elements given as a buffer of 'float' values of shape `(N, d)`, or of shape
+ * `(d,)` for a single domain element.
+ *
+ * @param ob_x The domain elements
+ * @param N The location to which to write the number of domain elements
+ * @param d The location to which to write the number of dimensions of the domain elements
+ * @param ndim The location to which to write the number of axes of the buffer
+ * @return A dynamically allocated row-major array of domain elements, or `NULL` upon failure
+ */
+static double *parse_points(PyObject *ob_x, Py_ssize_t *N, unsigned int *d, int *ndim) {
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(ob_x, &view, PyBUF_RECORDS_RO)) { return NULL; }
+
+    const char *format = view.format ? view.format : "B";
+    if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+    if (strcmp(format, "d") || view.ndim < 1 || view.ndim > 2) {
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'float' values with one or two axes");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+    *ndim = view.ndim;
+    *N = view.ndim == 2 ? *view.shape : 1;
+    *d = (unsigned int)*(view.shape + view.ndim - 1);
+    if (!*d) {
+        PyErr_SetString(PyExc_ValueError, "Expected domain elements with at least one dimension");
+        PyBuffer_Release(&view);
         return NULL;
     }
 
-    PyObject *tuple = PyTuple_New(d);
-    if (!tuple) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to instantiate new 'tuple' object");
-        Py_XDECREF(tuple);
-        free(x); free(res);
+    const Py_ssize_t size = *N * (Py_ssize_t)*d;
+    double *x = (double *)malloc((size ? size : 1) * sizeof(double));
+    if (!x) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+    for (Py_ssize_t j = 0; x && j < *N; ++j) {
+        const char *row = (const char *)view.buf + (view.ndim == 2 ? j * *view.strides : 0);
+        const Py_ssize_t stride = *(view.strides + view.ndim - 1);
+        for (unsigned int i = 0; i < *d; ++i) { *(x + j * *d + i) = *(const double *)(row + i * stride); }
+    }
+    PyBuffer_Release(&view);
+
+    return x;
+
+}
+
+/**
+ * Casts a 'bytearray' object of 'float' values to a `memoryview` of a given shape, stealing the
+ * reference to the 'bytearray' object. Empty values are cast to a flat `memoryview`.
+ *
+ * @param bytes The values
+ * @param naxes The number of axes
+ * @param shape The lengths of the axes
+ * @return A `memoryview` of the values, or `NULL` upon failure
+ */
+static PyObject *shaped_view(PyObject *bytes, int naxes, const Py_ssize_t *shape) {
+
+    PyObject *ob_shape = PyTuple_New(naxes);
+    for (int j = 0; ob_shape && j < naxes; ++j) {
+        PyObject *length = PyLong_FromSsize_t(*(shape + j));
+        if (!length) { Py_CLEAR(ob_shape); break; }
+        PyTuple_SET_ITEM(ob_shape, j, length);
+    }
+    PyObject *memory = ob_shape ? PyMemoryView_FromObject(bytes) : NULL;
+    PyObject *value = (
+        !memory ? NULL
+        : PyByteArray_GET_SIZE(bytes) ? PyObject_CallMethod(memory, "cast", "sO", "d", ob_shape)
+        : PyObject_CallMethod(memory, "cast", "s", "d")
+    );
+    Py_XDECREF(ob_shape); Py_XDECREF(memory); Py_DECREF(bytes);
+
+    return value;
+
+}
+
+/**
+ * Computes batched difference quotients from Python API arguments `(f, x, h, rule[, blocksize])`,
+ * returning a buffer of shape `x.shape[:-1] + shape` for each domain element in `x`.
+ *
+ * @param args The Python API arguments
+ * @param engine The function computing the difference quotients
+ * @param vector Whether to probe the number of values of `f`, preceding `shape` with it
+ * @param square Whether the difference quotients of each domain element form a `d` by `d` matrix
+ * @return A buffer of difference quotients, or `NULL` upon failure
+ */
+static PyObject *batch_quotients(PyObject *args, BatchEngine engine, short vector, short square) {
+
+    PyObject *ob_f;
+    PyObject *ob_x;
+    double h;
+    enum FinDiffRule rule;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(args, "OOdi|n", &ob_f, &ob_x, &h, &rule, &blocksize)) { return NULL; }
+    if (rule != FORWARD && rule != BACKWARD && rule != CENTRAL) {
+        PyErr_SetString(PyExc_ValueError, "Expected a finite difference rule");
         return NULL;
     }
 
-    for (unsigned int i = 0; i < d; ++i) {
-        if (PyTuple_SetItem(tuple, i, PyFloat_FromDouble(*(res + i)) != 0)) {
-            free(x); free(res);
-            return NULL;
-        }
+    Py_ssize_t N;
+    unsigned int d;
+    int ndim;
+    struct Function *f = parse_function(ob_f, blocksize);
+    double *x = f ? parse_points(ob_x, &N, &d, &ndim) : NULL;
+    if (x && vector && N && probe_function(f, x, d) == -1) { free(x); x = NULL; }
+
+    const Py_ssize_t size = N * (Py_ssize_t)(x ? f->outputs : 1) * d * (square ? d : 1);
+    PyObject *bytes = x ? PyByteArray_FromStringAndSize(NULL, size * sizeof(double)) : NULL;
+    if (!bytes || engine(f, x, N, d, h, rule, (double *)PyByteArray_AS_STRING(bytes)) == -1) {
+        Py_XDECREF(bytes);
+        free_function(f); free(x);
+        return NULL;
     }
 
-    free(x); free(res);
+    Py_ssize_t shape[4];
+    int naxes = 0;
+    if (ndim == 2) { shape[naxes++] = N; }
+    if (vector) { shape[naxes++] = f->outputs; }
+    if (square) { shape[naxes++] = d; }
+    shape[naxes++] = d;
+    free_function(f); free(x);
 
-    return tuple;
+    return shaped_view(bytes, naxes, shape);
+
+}
+
+/**
+ * Python API wrapper for `gradient`
+ */
+static PyObject *differential_gradient(PyObject *self, PyObject *args) {
+
+    return batch_quotients(args, gradient, 0, 0);
+
+}
+
+/**
+ * Python API wrapper for `gradient` over functions returning several values
+ */
+static PyObject *differential_jacobian(PyObject *self, PyObject *args) {
+
+    return batch_quotients(args, gradient, 1, 0);
+
+}
+
+/**
+ * Python API wrapper for `hessian`
+ */
+static PyObject *differential_hessian(PyObject *self, PyObject *args) {
+
+    return batch_quotients(args, hessian, 0, 1);
+
+}
+
+/**
+ * Python API wrapper for `complex_step`
+ */
+static PyObject *differential_complex_step(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_x;
+    double h = COMPLEX_STEP_SIZE;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(args, "OO|dn", &ob_f, &ob_x, &h, &blocksize)) { return NULL; }
+
+    Py_ssize_t N;
+    unsigned int d;
+    int ndim;
+    struct Function *f = parse_complex(ob_f, blocksize);
+    double *x = f ? parse_points(ob_x, &N, &d, &ndim) : NULL;
+    PyObject *bytes = x ? PyByteArray_FromStringAndSize(NULL, N * d * sizeof(double)) : NULL;
+    if (!bytes || complex_step(f, x, N, d, h, (double *)PyByteArray_AS_STRING(bytes)) == -1) {
+        Py_XDECREF(bytes);
+        free_function(f); free(x);
+        return NULL;
+    }
+    free_function(f); free(x);
+
+    Py_ssize_t shape[2] = { N, d };
+
+    return shaped_view(bytes, ndim, ndim == 2 ? shape : shape + 1);
 
 }
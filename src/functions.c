@@ -2,51 +2,271 @@
  * Source file for "../include/functions.c"
  */
 
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "../include/functions.h"
-#include "../include/numbers.h"
 
 
+static struct {
+    PyObject *cast;
+    PyObject *c_double;
+    PyObject *c_void_p;
+    PyObject *native;
+    PyObject *parametric;
+    PyObject *holomorphic;
+} ctypes;
+
 /**
- * Evaluates a mathematical function of several real variables at a specified domain element.
+ * Resolves the `ctypes` types of the native signatures, against which `ctypes` function pointers are
+ * checked. If `ctypes` cannot be imported, function pointers are not recognized. Each module built
+ * from this file calls it once upon initialization.
  *
- * @param f A callable representation of a mathematical function of several real variables
- * @param x The domain element at which to evaluate `f`
- * @param d The number of dimensions in the domain of `f`
- * @return The value of `f` at `x`, or `DNAN` upon failure
+ * @return `0` upon success, or `-1` upon failure
+ */
+short init_functions(void) {
+
+    if (ctypes.cast) { return 0; }
+
+    PyObject *module = PyImport_ImportModule("ctypes");
+    if (!module) {
+        PyErr_Clear();
+        return 0;
+    }
+
+    PyObject *c_uint = PyObject_GetAttrString(module, "c_uint");
+    ctypes.c_double = PyObject_GetAttrString(module, "c_double");
+    ctypes.c_void_p = PyObject_GetAttrString(module, "c_void_p");
+    ctypes.cast = PyObject_GetAttrString(module, "cast");
+    PyObject *pointer = ctypes.c_double ? PyObject_CallMethod(module, "POINTER", "O", ctypes.c_double) : NULL;
+    Py_DECREF(module);
+
+    if (c_uint && ctypes.c_void_p && ctypes.cast && pointer) {
+        ctypes.native = PyTuple_Pack(3, pointer, c_uint, ctypes.c_void_p);
+        ctypes.parametric = PyTuple_Pack(5, pointer, c_uint, pointer, c_uint, ctypes.c_void_p);
+        ctypes.holomorphic = PyTuple_Pack(4, pointer, c_uint, pointer, ctypes.c_void_p);
+    }
+    Py_XDECREF(c_uint); Py_XDECREF(pointer);
+    if (!ctypes.native || !ctypes.parametric || !ctypes.holomorphic) {
+        Py_CLEAR(ctypes.cast); Py_CLEAR(ctypes.c_double); Py_CLEAR(ctypes.c_void_p);
+        Py_CLEAR(ctypes.native); Py_CLEAR(ctypes.parametric); Py_CLEAR(ctypes.holomorphic);
+        return -1;
+    }
+
+    return 0;
+
+}
+
+/**
+ * Checks that the argument types of a `ctypes` function pointer, a sequence or `None`, are those of a
+ * 'tuple' of `ctypes` types.
+ *
+ * @return `1` if the argument types match, `0` if not, or `-1` upon failure
  */
-double eval(PyObject *f, double *x, unsigned int d) {
+static short check_argtypes(PyObject *actual, PyObject *expected) {
+
+    if (actual == Py_None) { return 0; }
+
+    PyObject *seq = PySequence_Fast(actual, "Expected a sequence of argument types");
+    if (!seq) { return -1; }
+
+    const Py_ssize_t n = PyTuple_GET_SIZE(expected);
+    short match = PySequence_Fast_GET_SIZE(seq) == n;
+    for (Py_ssize_t i = 0; match && i < n; ++i) {
+        match = PySequence_Fast_GET_ITEM(seq, i) == PyTuple_GET_ITEM(expected, i);
+    }
+    Py_DECREF(seq);
+
+    return match;
+
+}
+
+/**
+ * Resolves the address of a native function from a `ctypes` function pointer, checking its return and
+ * argument types against a signature. Callable objects with both `restype` and `argtypes` attributes
+ * are taken to be `ctypes` function pointers.
+ *
+ * @param ob_f The object to resolve
+ * @param signature The signature of the function, for error messages
+ * @param restype The `ctypes` type returned by the function, or `None`
+ * @param argtypes The 'tuple' of the `ctypes` types of the arguments of the function
+ * @param native The location to which to write the function address
+ * @return `1` if `ob_f` is a `ctypes` function pointer, `0` if not, or `-1` upon failure
+ */
+static short parse_ctypes(
+    PyObject *ob_f, const char *signature, PyObject *restype, PyObject *argtypes, void **native
+) {
+
+    if (!ctypes.cast || !PyCallable_Check(ob_f)) { return 0; }
+    if (!PyObject_HasAttrString(ob_f, "restype") || !PyObject_HasAttrString(ob_f, "argtypes")) { return 0; }
+
+    PyObject *actual_restype = PyObject_GetAttrString(ob_f, "restype");
+    PyObject *actual_argtypes = actual_restype ? PyObject_GetAttrString(ob_f, "argtypes") : NULL;
+    short match = actual_argtypes ? actual_restype == restype : -1;
+    if (match == 1) { match = check_argtypes(actual_argtypes, argtypes); }
+    Py_XDECREF(actual_restype); Py_XDECREF(actual_argtypes);
+    if (match <= 0) {
+        if (!match) {
+            PyErr_Format(
+                PyExc_TypeError, "Expected a 'ctypes' function pointer with the signature '%s'", signature
+            );
+        }
+        return -1;
+    }
 
-    if (!PyCallable_Check(f)) {
+    PyObject *address = PyObject_CallFunctionObjArgs(ctypes.cast, ob_f, ctypes.c_void_p, NULL);
+    if (!address) { return -1; }
+
+    PyObject *value = PyObject_GetAttrString(address, "value");
+    Py_DECREF(address);
+    if (!value) { return -1; }
+
+    void *ptr = value == Py_None ? NULL : PyLong_AsVoidPtr(value);
+    Py_DECREF(value);
+    if (!ptr) {
+        if (!PyErr_Occurred()) { PyErr_SetString(PyExc_ValueError, "Expected a non-null function pointer"); }
+        return -1;
+    }
+    *native = ptr;
+
+    return 1;
+
+}
+
+/**
+ * Parses a Python object as a representation of a mathematical function of several real variables.
+ *
+ * Besides callable objects, native functions with the signature `NATIVE_SIGNATURE` are accepted as a
+ * `PyCapsule` named by that signature (whose context, if any, is passed as `userdata`) or as a
+ * `ctypes` function pointer with the return and argument types of that signature. Native functions are
+ * called directly.
+ *
+ * @param ob_f A representation of a mathematical function of several real variables
+ * @param blocksize The number of domain elements per call if `ob_f` is vectorized, or `0` otherwise
+ * @return A dynamically allocated function representation, or `NULL` upon failure
+ */
+struct Function *parse_function(PyObject *ob_f, Py_ssize_t blocksize) {
+
+    if (blocksize < 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected a non-negative block size");
+        return NULL;
+    }
+
+    struct Function *f = (struct Function *)malloc(sizeof(struct Function));
+    if (!f) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    f->callable = ob_f;
+    f->native = NULL;
+    f->parametric = NULL;
+    f->holomorphic = NULL;
+    f->userdata = NULL;
+    f->outputs = 1;
+    f->memo = NULL;
+
+    if (PyCapsule_CheckExact(ob_f)) {
+        if (!(f->native = (NativeFunction)PyCapsule_GetPointer(ob_f, NATIVE_SIGNATURE))) {
+            PyErr_SetString(PyExc_TypeError, "Expected a capsule named '" NATIVE_SIGNATURE "'");
+            free(f);
+            return NULL;
+        }
+        f->userdata = PyCapsule_GetContext(ob_f);
+        f->type = NATIVE;
+        f->blocksize = blocksize ? blocksize : NATIVE_BLOCKSIZE;
+        return f;
+    }
+
+    void *ptr;
+    short isnative = parse_ctypes(ob_f, NATIVE_SIGNATURE, ctypes.c_double, ctypes.native, &ptr);
+    if (isnative < 0) {
+        free(f);
+        return NULL;
+    }
+    if (isnative) {
+        f->native = (NativeFunction)ptr;
+        f->type = NATIVE;
+        f->blocksize = blocksize ? blocksize : NATIVE_BLOCKSIZE;
+        return f;
+    }
+
+    if (!PyCallable_Check(ob_f)) {
         PyErr_SetString(PyExc_TypeError, "Expected a callable object");
-        return DNAN;
+        free(f);
+        return NULL;
     }
 
-    PyObject *ob_x;
-    if (!PyTuple_New(d)) {
+    f->type = blocksize ? VECTORIZED : SCALAR;
+    f->blocksize = blocksize ? blocksize : 1;
+
+    return f;
+
+}
+
+/**
+ * Packs a domain element into a 'tuple' of 'float' objects.
+ */
+static PyObject *pack_point(const double *x, unsigned int d) {
+
+    PyObject *ob_x = PyTuple_New(d);
+    if (!ob_x) {
         PyErr_SetString(PyExc_MemoryError, "Failed to instantiate 'tuple' object");
-        return DNAN;
+        return NULL;
     }
 
     for (unsigned int i = 0; i < d; ++i) {
         PyObject *item = PyFloat_FromDouble(*(x + i));
         if (!item) {
             PyErr_SetString(PyExc_RuntimeError, "Failed to convert 'float' object to double");
-            Py_DECREF(item);
-            return DNAN;
+            Py_DECREF(ob_x);
+            return NULL;
         }
-        PyTuple_SetItem(ob_x, (Py_ssize_t)i, item);
+        PyTuple_SET_ITEM(ob_x, (Py_ssize_t)i, item);
     }
 
-    PyObject *res = PyObject_CallOneArg(f, ob_x);
+    return ob_x;
+
+}
+
+/**
+ * Calls a scalar function with a domain element packed into a 'tuple' of 'float' objects.
+ */
+static PyObject *call_point(struct Function *f, double *x, unsigned int d) {
+
+    PyObject *ob_x = pack_point(x, d);
+    if (!ob_x) { return NULL; }
+
+    PyObject *res = PyObject_CallOneArg(f->callable, ob_x);
     Py_DECREF(ob_x);
-    if (!res) {
-        PyErr_SetString(PyExc_RuntimeError, "Failed to call callable object");
-        return DNAN;
+
+    return res;
+
+}
+
+/**
+ * Evaluates a mathematical function of several real variables at a specified domain element.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x The domain element at which to evaluate `f`
+ * @param d The number of dimensions in the domain of `f`
+ * @return The value of `f` at `x`, or `NAN` upon failure
+ */
+double eval(struct Function *f, double *x, unsigned int d) {
+
+    if (f->type == NATIVE) { return f->native(x, d, f->userdata); }
+    if (f->type == VECTORIZED) {
+        double y;
+        return eval_block(f, x, 1, d, &y) ? NAN : y;
     }
+
+    PyObject *res = call_point(f, x, d);
+    if (!res) { return NAN; }
     if (!PyFloat_Check(res)) {
         PyErr_SetString(PyExc_TypeError, "Expected callable object to return a 'float' object");
         Py_DECREF(res);
-        return DNAN;
+        return NAN;
     }
     double value = PyFloat_AsDouble(res);
     Py_DECREF(res);
@@ -54,3 +274,551 @@ double eval(PyObject *f, double *x, unsigned int d) {
     return value;
 
 }
+
+/**
+ * Packs a block of domain elements into a two-dimensional `memoryview` of shape `(N, d)`.
+ */
+static PyObject *pack_block(double *x, Py_ssize_t N, unsigned int d) {
+
+    PyObject *bytes = PyByteArray_FromStringAndSize(
+        (const char *)x, N * (Py_ssize_t)d * (Py_ssize_t)sizeof(double)
+    );
+    if (!bytes) { return NULL; }
+
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (!view) { return NULL; }
+
+    PyObject *block = PyObject_CallMethod(view, "cast", "s(nI)", "d", N, d);
+    Py_DECREF(view);
+
+    return block;
+
+}
+
+/**
+ * Unpacks `N` rows of `m` function values from an object supporting the buffer protocol, or from a
+ * sequence of rows, each a 'float' object if `m` is `1`, or a sequence or buffer of `m` values.
+ */
+static short unpack_block(PyObject *ob_y, Py_ssize_t N, unsigned int m, double *y) {
+
+    Py_buffer view;
+    if (PyObject_CheckBuffer(ob_y) && !PyObject_GetBuffer(ob_y, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+
+        const char *format = view.format ? view.format : "B";
+        if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+        if (strcmp(format, "d") || view.len != N * (Py_ssize_t)m * (Py_ssize_t)sizeof(double)) {
+            PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'float' values, one per domain element");
+            PyBuffer_Release(&view);
+            return -1;
+        }
+
+        memcpy(y, view.buf, view.len);
+        PyBuffer_Release(&view);
+
+        return 0;
+
+    }
+    PyErr_Clear();
+
+    PyObject *seq = PySequence_Fast(ob_y, "Expected a sequence of 'float' objects");
+    if (!seq) { return -1; }
+    if (PySequence_Fast_GET_SIZE(seq) != N) {
+        PyErr_SetString(PyExc_ValueError, "Expected one 'float' object per domain element");
+        Py_DECREF(seq);
+        return -1;
+    }
+
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < N; ++i) {
+        if (m > 1) {
+            if (unpack_block(*(items + i), m, 1, y + i * m) == -1) {
+                Py_DECREF(seq);
+                return -1;
+            }
+            continue;
+        }
+        *(y + i) = PyFloat_AsDouble(*(items + i));
+        if (*(y + i) == -1. && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+
+    return 0;
+
+}
+
+/**
+ * Counts the values of a function at one domain element: `1` for a 'float' object, and the length of
+ * a sequence or of a buffer of 'float' values otherwise.
+ */
+static Py_ssize_t count_values(PyObject *res) {
+
+    if (PyFloat_Check(res)) { return 1; }
+
+    Py_buffer view;
+    if (PyObject_CheckBuffer(res) && !PyObject_GetBuffer(res, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+        const char *format = view.format ? view.format : "B";
+        if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+        Py_ssize_t m = strcmp(format, "d") ? 0 : view.len / (Py_ssize_t)sizeof(double);
+        PyBuffer_Release(&view);
+        return m;
+    }
+    PyErr_Clear();
+
+    return PySequence_Check(res) ? PySequence_Size(res) : 0;
+
+}
+
+/**
+ * Determines the number of values of a function, so that integrands `f: R^d -> R^m` can be
+ * accumulated as a vector. The function is evaluated once at `x`, and `x` and its values are kept so
+ * that the next call to `eval_block` reuses them if it starts at `x`; native functions have one value
+ * and are not evaluated.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x A domain element at which `f` can be evaluated
+ * @param d The number of dimensions in the domain of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short probe_function(struct Function *f, double *x, unsigned int d) {
+
+    f->outputs = 1;
+    free(f->memo);
+    f->memo = NULL;
+    if (f->type == NATIVE) { return 0; }
+
+    PyObject *res;
+    if (f->type == SCALAR) {
+        res = call_point(f, x, d);
+    } else {
+        PyObject *block = pack_block(x, 1, d);
+        res = block ? PyObject_CallOneArg(f->callable, block) : NULL;
+        Py_XDECREF(block);
+    }
+    if (!res) { return -1; }
+
+    Py_ssize_t m = count_values(res);
+    if (f->type == VECTORIZED && m == 1 && !PyObject_CheckBuffer(res)) {
+        PyObject *row = PySequence_GetItem(res, 0);
+        m = row ? count_values(row) : -1;
+        Py_XDECREF(row);
+    }
+    if (m == -1 && PyErr_Occurred()) {
+        Py_DECREF(res);
+        return -1;
+    }
+    if (m < 1 || m > UINT_MAX) {
+        PyErr_SetString(PyExc_TypeError, "Expected a function returning a 'float' object or a sequence");
+        Py_DECREF(res);
+        return -1;
+    }
+    if (f->type == SCALAR && m == 1 && !PyFloat_Check(res)) {
+        PyErr_SetString(PyExc_TypeError, "Expected callable object to return a 'float' object");
+        Py_DECREF(res);
+        return -1;
+    }
+
+    double *memo = (double *)malloc((d + m) * sizeof(double));
+    if (!memo) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        Py_DECREF(res);
+        return -1;
+    }
+    memcpy(memo, x, d * sizeof(double));
+    short err = 0;
+    if (f->type == VECTORIZED) {
+        err = unpack_block(res, 1, (unsigned int)m, memo + d);
+    } else if (m > 1) {
+        err = unpack_block(res, m, 1, memo + d);
+    } else {
+        *(memo + d) = PyFloat_AsDouble(res);
+    }
+    Py_DECREF(res);
+    if (err == -1) {
+        free(memo);
+        return -1;
+    }
+    f->outputs = (unsigned int)m;
+    f->memo = memo;
+
+    return 0;
+
+}
+
+/**
+ * Frees a function representation, along with the values kept by `probe_function`.
+ */
+void free_function(struct Function *f) {
+
+    if (!f) { return; }
+    free(f->memo);
+    free(f);
+
+}
+
+/**
+ * Evaluates a mathematical function of several real variables at a block of domain elements.
+ *
+ * Scalar functions are called once per domain element. Vectorized functions are called once per
+ * block with a `memoryview` of shape `(N, d)`, and are expected to return `N` values as an object
+ * supporting the buffer protocol (e.g. a `numpy.ndarray`) or as a sequence of 'float' objects.
+ * Native functions are called once per domain element with the GIL released, and signals are checked
+ * after each block so that long computations can be interrupted. Functions with several
+ * values per domain element, as set by `probe_function`, return a row of `f->outputs` values where
+ * others return a 'float' object, and vectorized ones may return a buffer of shape `(N, m)`. If the
+ * first domain element is the one just probed by `probe_function`, its values are reused.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param x The row-major array of `N` domain elements at which to evaluate `f`
+ * @param N The number of domain elements in `x`
+ * @param d The number of dimensions in the domain of `f`
+ * @param y The row-major array to which to write the `N` rows of `f->outputs` values of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short eval_block(struct Function *f, double *x, Py_ssize_t N, unsigned int d, double *y) {
+
+    if (f->memo) {
+        const short reuse = N > 0 && !memcmp(x, f->memo, d * sizeof(double));
+        if (reuse) { memcpy(y, f->memo + d, f->outputs * sizeof(double)); }
+        free(f->memo);
+        f->memo = NULL;
+        if (reuse) { return N > 1 ? eval_block(f, x + d, N - 1, d, y + f->outputs) : 0; }
+    }
+    if (f->type == NATIVE) {
+        Py_BEGIN_ALLOW_THREADS
+        for (Py_ssize_t i = 0; i < N; ++i) { *(y + i) = f->native(x + i * d, d, f->userdata); }
+        Py_END_ALLOW_THREADS
+        return PyErr_CheckSignals() == -1 ? -1 : 0;
+    }
+    if (f->type == SCALAR && f->outputs == 1) {
+        for (Py_ssize_t i = 0; i < N; ++i) {
+            *(y + i) = eval(f, x + i * d, d);
+            if (PyErr_Occurred()) { return -1; }
+        }
+        return 0;
+    }
+    if (f->type == SCALAR) {
+        for (Py_ssize_t i = 0; i < N; ++i) {
+            PyObject *res = call_point(f, x + i * d, d);
+            short err = res ? unpack_block(res, f->outputs, 1, y + i * f->outputs) : -1;
+            Py_XDECREF(res);
+            if (err == -1) { return -1; }
+        }
+        return 0;
+    }
+
+    PyObject *block = pack_block(x, N, d);
+    if (!block) { return -1; }
+
+    PyObject *res = PyObject_CallOneArg(f->callable, block);
+    Py_DECREF(block);
+    if (!res) { return -1; }
+
+    short err = unpack_block(res, N, f->outputs, y);
+    Py_DECREF(res);
+
+    return err;
+
+}
+
+/**
+ * Parses a Python object as a representation of a family of mathematical functions of several real
+ * variables, indexed by a vector of parameters.
+ *
+ * Native functions with the signature `PARAMETRIC_SIGNATURE` are accepted as a `PyCapsule` named by
+ * that signature or as a `ctypes` function pointer with the return and argument types of that signature.
+ * Scalar callables are called as `f(x, p)` with two 'tuple' objects, and vectorized ones as `f(x, p)`
+ * with `memoryview` objects of shapes `(N, d)` and `(P, q)`.
+ *
+ * @param ob_f A representation of a family of mathematical functions of several real variables
+ * @param blocksize The number of domain elements per call if `ob_f` is vectorized, or `0` otherwise
+ * @return A dynamically allocated function representation, or `NULL` upon failure
+ */
+struct Function *parse_parametric(PyObject *ob_f, Py_ssize_t blocksize) {
+
+    if (blocksize < 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected a non-negative block size");
+        return NULL;
+    }
+
+    void *ptr = NULL;
+    short isnative = PyCapsule_CheckExact(ob_f)
+        ? 0 : parse_ctypes(ob_f, PARAMETRIC_SIGNATURE, ctypes.c_double, ctypes.parametric, &ptr);
+    if (isnative < 0) { return NULL; }
+    if (!isnative && !PyCapsule_CheckExact(ob_f)) { return parse_function(ob_f, blocksize); }
+
+    struct Function *f = (struct Function *)malloc(sizeof(struct Function));
+    if (!f) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    f->callable = ob_f;
+    f->native = NULL;
+    f->holomorphic = NULL;
+    f->userdata = NULL;
+    f->outputs = 1;
+    f->memo = NULL;
+    f->type = NATIVE;
+    f->blocksize = blocksize ? blocksize : NATIVE_BLOCKSIZE;
+
+    if (isnative) {
+        f->parametric = (ParametricFunction)ptr;
+        return f;
+    }
+    if (!(f->parametric = (ParametricFunction)PyCapsule_GetPointer(ob_f, PARAMETRIC_SIGNATURE))) {
+        PyErr_SetString(PyExc_TypeError, "Expected a capsule named '" PARAMETRIC_SIGNATURE "'");
+        free(f);
+        return NULL;
+    }
+    f->userdata = PyCapsule_GetContext(ob_f);
+
+    return f;
+
+}
+
+/**
+ * Evaluates a family of mathematical functions of several real variables at a block of domain
+ * elements, for each of a block of parameters.
+ *
+ * @param f A representation of a family of mathematical functions, as parsed by `parse_parametric`
+ * @param x The row-major array of `N` domain elements at which to evaluate `f`
+ * @param N The number of domain elements in `x`
+ * @param d The number of dimensions in the domain of `f`
+ * @param p The row-major array of `P` parameters
+ * @param P The number of parameters in `p`
+ * @param q The number of components of each parameter
+ * @param y The row-major array to which to write the `P` rows of `N` values of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short eval_parametric(
+    struct Function *f, double *x, Py_ssize_t N, unsigned int d, double *p, Py_ssize_t P, unsigned int q,
+    double *y
+) {
+
+    if (f->type == NATIVE) {
+        Py_BEGIN_ALLOW_THREADS
+        for (Py_ssize_t j = 0; j < P; ++j) {
+            for (Py_ssize_t i = 0; i < N; ++i) {
+                *(y + j * N + i) = f->parametric(x + i * d, d, p + j * q, q, f->userdata);
+            }
+        }
+        Py_END_ALLOW_THREADS
+        return PyErr_CheckSignals() == -1 ? -1 : 0;
+    }
+
+    if (f->type == VECTORIZED) {
+        PyObject *block = pack_block(x, N, d);
+        PyObject *params = block ? pack_block(p, P, q) : NULL;
+        PyObject *res = params ? PyObject_CallFunctionObjArgs(f->callable, block, params, NULL) : NULL;
+        Py_XDECREF(block); Py_XDECREF(params);
+        if (!res) { return -1; }
+        short err = unpack_block(res, P, (unsigned int)N, y);
+        Py_DECREF(res);
+        return err;
+    }
+
+    for (Py_ssize_t i = 0; i < N; ++i) {
+
+        PyObject *ob_x = pack_point(x + i * d, d);
+        if (!ob_x) { return -1; }
+
+        for (Py_ssize_t j = 0; j < P; ++j) {
+            PyObject *ob_p = pack_point(p + j * q, q);
+            PyObject *res = ob_p ? PyObject_CallFunctionObjArgs(f->callable, ob_x, ob_p, NULL) : NULL;
+            Py_XDECREF(ob_p);
+            *(y + j * N + i) = res ? PyFloat_AsDouble(res) : -1.;
+            Py_XDECREF(res);
+            if (PyErr_Occurred()) {
+                Py_DECREF(ob_x);
+                return -1;
+            }
+        }
+        Py_DECREF(ob_x);
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Parses a Python object as a representation of a mathematical function of several complex variables,
+ * such as the analytic extension of a mathematical function of several real variables.
+ *
+ * Complex numbers are stored as consecutive pairs of real and imaginary parts, as in `double complex`
+ * arrays. Native functions with the signature `COMPLEX_SIGNATURE`, writing the value at `d` complex
+ * numbers to a pair of real and imaginary parts, are accepted as a `PyCapsule` named by that signature
+ * or as a `ctypes` function pointer with the return and argument types of that signature. Scalar
+ * callables are called with a 'tuple' of 'complex' objects and return a 'complex' object, and vectorized
+ * ones are called with a `memoryview` of shape `(N, d, 2)` and return a sequence of `N` 'complex'
+ * objects or a buffer of `N` pairs.
+ *
+ * @param ob_f A representation of a mathematical function of several complex variables
+ * @param blocksize The number of domain elements per call if `ob_f` is vectorized, or `0` otherwise
+ * @return A dynamically allocated function representation, or `NULL` upon failure
+ */
+struct Function *parse_complex(PyObject *ob_f, Py_ssize_t blocksize) {
+
+    if (blocksize < 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected a non-negative block size");
+        return NULL;
+    }
+
+    struct Function *f = (struct Function *)malloc(sizeof(struct Function));
+    if (!f) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    f->callable = ob_f;
+    f->native = NULL;
+    f->parametric = NULL;
+    f->holomorphic = NULL;
+    f->userdata = NULL;
+    f->outputs = 1;
+    f->memo = NULL;
+
+    if (PyCapsule_CheckExact(ob_f)) {
+        if (!(f->holomorphic = (ComplexFunction)PyCapsule_GetPointer(ob_f, COMPLEX_SIGNATURE))) {
+            PyErr_SetString(PyExc_TypeError, "Expected a capsule named '" COMPLEX_SIGNATURE "'");
+            free(f);
+            return NULL;
+        }
+        f->userdata = PyCapsule_GetContext(ob_f);
+        f->type = NATIVE;
+        f->blocksize = blocksize ? blocksize : NATIVE_BLOCKSIZE;
+        return f;
+    }
+
+    void *ptr;
+    short isnative = parse_ctypes(ob_f, COMPLEX_SIGNATURE, Py_None, ctypes.holomorphic, &ptr);
+    if (isnative < 0) {
+        free(f);
+        return NULL;
+    }
+    if (isnative) {
+        f->holomorphic = (ComplexFunction)ptr;
+        f->type = NATIVE;
+        f->blocksize = blocksize ? blocksize : NATIVE_BLOCKSIZE;
+        return f;
+    }
+
+    if (!PyCallable_Check(ob_f)) {
+        PyErr_SetString(PyExc_TypeError, "Expected a callable object");
+        free(f);
+        return NULL;
+    }
+
+    f->type = blocksize ? VECTORIZED : SCALAR;
+    f->blocksize = blocksize ? blocksize : 1;
+
+    return f;
+
+}
+
+/**
+ * Unpacks the complex values of a function at a block of domain elements, given as a buffer of `N`
+ * 'complex' values or `N` pairs of 'float' values, or as a sequence of `N` 'complex' objects.
+ */
+static short unpack_complex(PyObject *ob_w, Py_ssize_t N, double *w) {
+
+    Py_buffer view;
+    if (PyObject_CheckBuffer(ob_w) && !PyObject_GetBuffer(ob_w, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS)) {
+
+        const char *format = view.format ? view.format : "B";
+        if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+        if ((strcmp(format, "d") && strcmp(format, "Zd")) || view.len != 2 * N * (Py_ssize_t)sizeof(double)) {
+            PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'complex' values, one per domain element");
+            PyBuffer_Release(&view);
+            return -1;
+        }
+
+        memcpy(w, view.buf, view.len);
+        PyBuffer_Release(&view);
+
+        return 0;
+
+    }
+    PyErr_Clear();
+
+    PyObject *seq = PySequence_Fast(ob_w, "Expected a sequence of 'complex' objects");
+    if (!seq) { return -1; }
+    if (PySequence_Fast_GET_SIZE(seq) != N) {
+        PyErr_SetString(PyExc_ValueError, "Expected one 'complex' object per domain element");
+        Py_DECREF(seq);
+        return -1;
+    }
+
+    PyObject **items = PySequence_Fast_ITEMS(seq);
+    for (Py_ssize_t i = 0; i < N; ++i) {
+        Py_complex value = PyComplex_AsCComplex(*(items + i));
+        if (value.real == -1. && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+        *(w + 2 * i) = value.real, *(w + 2 * i + 1) = value.imag;
+    }
+    Py_DECREF(seq);
+
+    return 0;
+
+}
+
+/**
+ * Evaluates a mathematical function of several complex variables at a block of domain elements.
+ *
+ * @param f A representation of a mathematical function of several complex variables, as parsed by
+ * `parse_complex`
+ * @param z The row-major array of `N` domain elements, each of `d` pairs of real and imaginary parts
+ * @param N The number of domain elements in `z`
+ * @param d The number of dimensions in the domain of `f`
+ * @param w The array to which to write the `N` pairs of real and imaginary parts of the values of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short eval_complex(struct Function *f, double *z, Py_ssize_t N, unsigned int d, double *w) {
+
+    if (f->type == NATIVE) {
+        Py_BEGIN_ALLOW_THREADS
+        for (Py_ssize_t i = 0; i < N; ++i) { f->holomorphic(z + 2 * i * d, d, w + 2 * i, f->userdata); }
+        Py_END_ALLOW_THREADS
+        return PyErr_CheckSignals() == -1 ? -1 : 0;
+    }
+
+    if (f->type == VECTORIZED) {
+        PyObject *bytes = PyByteArray_FromStringAndSize(
+            (const char *)z, 2 * N * (Py_ssize_t)d * (Py_ssize_t)sizeof(double)
+        );
+        PyObject *view = bytes ? PyMemoryView_FromObject(bytes) : NULL;
+        PyObject *block = view ? PyObject_CallMethod(view, "cast", "s(nIi)", "d", N, d, 2) : NULL;
+        PyObject *res = block ? PyObject_CallOneArg(f->callable, block) : NULL;
+        Py_XDECREF(bytes); Py_XDECREF(view); Py_XDECREF(block);
+        if (!res) { return -1; }
+        short err = unpack_complex(res, N, w);
+        Py_DECREF(res);
+        return err;
+    }
+
+    for (Py_ssize_t i = 0; i < N; ++i) {
+
+        PyObject *ob_z = PyTuple_New(d);
+        for (unsigned int k = 0; ob_z && k < d; ++k) {
+            PyObject *item = PyComplex_FromDoubles(*(z + 2 * (i * d + k)), *(z + 2 * (i * d + k) + 1));
+            if (!item) { Py_CLEAR(ob_z); break; }
+            PyTuple_SET_ITEM(ob_z, k, item);
+        }
+        PyObject *res = ob_z ? PyObject_CallOneArg(f->callable, ob_z) : NULL;
+        Py_XDECREF(ob_z);
+        if (!res) { return -1; }
+
+        Py_complex value = PyComplex_AsCComplex(res);
+        Py_DECREF(res);
+        if (value.real == -1. && PyErr_Occurred()) { return -1; }
+        *(w + 2 * i) = value.real, *(w + 2 * i + 1) = value.imag;
+
+    }
+
+    return 0;
+
+}
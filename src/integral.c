@@ -2,10 +2,19 @@
  * Source file for "../include/integral.h"
  */
 
+#include <float.h>
+#include <limits.h>
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include "../include/functions.h"
 #include "../include/integral.h"
+#include "../include/parallel.h"
+#include "../include/reduction.h"
+#include "../include/rulecache.h"
+#include "../include/samples.h"
 
 
 struct Interval *parse_interval(PyObject *ob_interval) {
@@ -64,7 +73,7 @@ struct Interval **parse_intervals(PyObject *ob_intervals, unsigned int *d) {
         PyObject *item = PySequence_GetItem(ob_intervals, i);
         if (!item) {
             PyErr_SetString(PyExc_RuntimeError, "Failed to access sequence contents");
-            PY_XDECREF(item);
+            Py_XDECREF(item);
             for (unsigned int j = 0; j < i; ++j) { free(*(intervals + i)); }
             free(intervals);
             return NULL;
@@ -102,6 +111,24 @@ double delta(struct Interval **intervals, unsigned int d) {
 
 }
 
+/**
+ * Checks that every interval has finite bounds, as required by all engines but `tanhsinh`.
+ *
+ * @return `0` if every interval is bounded, or `-1` otherwise
+ */
+short bounded(struct Interval **intervals, unsigned int d) {
+
+    for (unsigned int i = 0; i < d; ++i) {
+        if (!isfinite((*(intervals + i))->lower) || !isfinite((*(intervals + i))->upper)) {
+            PyErr_SetString(PyExc_ValueError, "Expected finite interval bounds");
+            return -1;
+        }
+    }
+
+    return 0;
+
+}
+
 short endpoint(struct Interval *interval, unsigned int i, double *x) {
 
     if (!(0 <= i <= interval->n + 1)) { return -1; }
@@ -171,7 +198,7 @@ enum RiemannRules *parse_rrules(PyObject *ob_rrules) {
         PyObject *item = PySequence_GetItem(ob_rrules, i);
         if (!item) {
             PyErr_SetString(PyExc_RuntimeError, "Failed to access sequence contents");
-            PY_XDECREF(item);
+            Py_XDECREF(item);
             free(rrules);
             return NULL;
         }
@@ -181,276 +208,4483 @@ enum RiemannRules *parse_rrules(PyObject *ob_rrules) {
             free(rrules);
             return NULL;
         }
-        *(rrules + i) = (enum RiemannRules)PyLong_AsInt(item);
+        const long value = PyLong_AsLong(item);
         Py_DECREF(item);
+        if (value < LEFT || value > TRAPEZOID) {
+            if (!PyErr_Occurred() || PyErr_ExceptionMatches(PyExc_OverflowError)) {
+                PyErr_Clear();
+                PyErr_SetString(PyExc_ValueError, "Expected a sequence of rule constants");
+            }
+            free(rrules);
+            return NULL;
+        }
+        *(rrules + i) = (enum RiemannRules)value;
     }
 
     return rrules;
 
 }
 
-static unsigned short inbounds(struct Interval **intervals, unsigned int radix, unsigned int d) {
+/**
+ * Parses a sequence of rules, one per interval, among the Riemann rules and the rules of
+ * `enum QuadratureRules`.
+ */
+enum QuadratureRules *parse_rules(PyObject *ob_rules) {
 
-    unsigned int bound = 1;
-    for (int i = 0; i < d; ++i) { bound *= (*(intervals + i))->n; }
+    enum RiemannRules *rrules = parse_rrules(ob_rules);
+    if (!rrules) { return NULL; }
+
+    const Py_ssize_t d = PySequence_Size(ob_rules);
+    enum QuadratureRules *rules = (enum QuadratureRules *)calloc(d, sizeof(enum QuadratureRules));
+    if (!rules) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(rrules);
+        return NULL;
+    }
+    for (Py_ssize_t i = 0; i < d; ++i) { *(rules + i) = (enum QuadratureRules)*(rrules + i); }
+    free(rrules);
 
-    return 0 <= radix <= bound;
+    return rules;
 
 }
 
-static unsigned int increment(struct Interval **intervals, unsigned int radix, unsigned int d) {
+/**
+ * Precomputes the domain elements and weights along each interval of a tensor-product grid.
+ *
+ * Along each interval, the weight of each domain element is the width of a subinterval, halved at
+ * both endpoints if `extra` is set. The weight of a domain element of the grid is the product of the
+ * weights along each interval.
+ *
+ * @param intervals The intervals spanning the grid
+ * @param rules The rule used to compute the domain elements along each interval
+ * @param d The number of intervals
+ * @param extra The number of domain elements along each interval in excess of its subintervals
+ * @return A dynamically allocated grid, or `NULL` upon failure
+ */
+struct Grid *build_grid(
+    struct Interval **intervals, RiemannRule *rules, unsigned int d, unsigned int extra
+) {
 
-    unsigned int base = (*intervals)->n;
-    unsigned int msd = radix / base;
+    if (bounded(intervals, d) == -1) { return NULL; }
 
-    if (d == 1) {
-        return (msd >= base - 1 ? 0 : msd + 1);
+    struct Grid *grid = (struct Grid *)malloc(sizeof(struct Grid));
+    if (!grid) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    grid->d = d;
+    grid->sizes = (unsigned int *)calloc(d, sizeof(unsigned int));
+    grid->nodes = (double **)calloc(d, sizeof(double *));
+    grid->weights = (double **)calloc(d, sizeof(double *));
+    if (!grid->sizes || !grid->nodes || !grid->weights) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free_grid(grid);
+        return NULL;
     }
-    return (msd >= base - 1 ? 0 : (msd + 1) * base + increment(intervals + 1, radix % base, d - 1));
 
-}
+    grid->npoints = 1;
+    for (unsigned int i = 0; i < d; ++i) {
 
-static unsigned int *unpack(struct Interval **intervals, unsigned int radix, unsigned int d) {
+        struct Interval *interval = *(intervals + i);
+        if (interval->n == 0) {
+            PyErr_SetString(PyExc_ValueError, "Expected a positive number of subintervals");
+            free_grid(grid);
+            return NULL;
+        }
 
-    unsigned int *index;
-    if (!(index = (unsigned int *)calloc(d, sizeof(unsigned int)))) { return NULL; }
+        const unsigned int size = interval->n + extra;
+        if (grid->npoints > UINT64_MAX / size) {
+            PyErr_SetString(PyExc_OverflowError, "Too many domain elements in grid");
+            free_grid(grid);
+            return NULL;
+        }
+        *(grid->sizes + i) = size;
+        grid->npoints *= size;
+
+        double *nodes = *(grid->nodes + i) = (double *)calloc(size, sizeof(double));
+        double *weights = *(grid->weights + i) = (double *)calloc(size, sizeof(double));
+        if (!nodes || !weights) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            free_grid(grid);
+            return NULL;
+        }
+
+        const double dx = (interval->upper - interval->lower) / interval->n;
+        for (unsigned int j = 0; j < size; ++j) {
+            (*(rules + i))(interval, j, nodes + j);
+            *(weights + j) = dx;
+        }
+        if (extra) { *weights /= 2, *(weights + size - 1) /= 2; }
 
-    for (int i = 0; i < d; ++i) {
-        *(index + i) = radix / (*(intervals + i))->n;
-        radix %= (*(intervals + i))->n;
     }
 
-    return index;
+    return grid;
 
 }
 
-static short xvalue(
-    struct Interval **intervals, RiemannRule *rules, unsigned int radix, unsigned int d,
-    double *x
-) {
+void free_grid(struct Grid *grid) {
 
-    unsigned int *index;
-    if (!(index = unpack(intervals, radix, d))) { return NULL; }
+    if (!grid) { return; }
+    for (unsigned int i = 0; i < grid->d; ++i) {
+        if (grid->nodes) { free(*(grid->nodes + i)); }
+        if (grid->weights) { free(*(grid->weights + i)); }
+    }
+    free(grid->sizes); free(grid->nodes); free(grid->weights);
+    free(grid);
 
-    for (int i = 0; i < d; ++i) {
-        if ((*(rules + i))(*(intervals + i), *(index + i), x) == -1) { return -1; }
+}
+
+/**
+ * Allocates the traversal state of a grid. The index, domain element and running products of the
+ * weights are kept so that stepping to the next domain element only updates the axes that change.
+ */
+struct Odometer *new_odometer(struct Grid *grid) {
+
+    struct Odometer *odometer = (struct Odometer *)malloc(sizeof(struct Odometer));
+    if (!odometer) { return NULL; }
+
+    odometer->index = (unsigned int *)calloc(grid->d, sizeof(unsigned int));
+    odometer->x = (double *)calloc(grid->d, sizeof(double));
+    odometer->w = (double *)calloc(grid->d + 1, sizeof(double));
+    if (!odometer->index || !odometer->x || !odometer->w) {
+        free_odometer(odometer);
+        return NULL;
     }
+    *odometer->w = 1.;
 
-    return 0;
+    return odometer;
 
 }
 
-short riemann(PyObject *f, struct Interval **intervals, enum RiemannRules *rrules, unsigned int d, double *res) {
+void free_odometer(struct Odometer *odometer) {
 
-    RiemannRule *rules = (RiemannRule *)calloc(d, sizeof(RiemannRule));
-    double *x = (double *)calloc(d, sizeof(double));
-    if (!rules || !x) {
-        free(rules); free(x);
-        res = NULL;
-        return -1;
-    }
-    
-    for (unsigned int i = 0; i < d; ++i) {
-        switch (*(rrules + i)) {
-            case LEFT:
-                *(rules + i) = left;
-                break;
-            case RIGHT:
-                *(rules + i) = right;
-                break;
-            case MIDPOINT:
-                *(rules + i) = midpoint;
-                break;
-            default:
-                free(rules); free(x);
-                res = NULL;
-                return -1;
-        }
+    if (!odometer) { return; }
+    free(odometer->index); free(odometer->x); free(odometer->w);
+    free(odometer);
+
+}
+
+/**
+ * Updates the domain element and running weights of an odometer from axis `i` onward.
+ */
+static void refresh(struct Grid *grid, struct Odometer *odometer, unsigned int i) {
+
+    for (; i < grid->d; ++i) {
+        const unsigned int j = *(odometer->index + i);
+        *(odometer->x + i) = *(*(grid->nodes + i) + j);
+        *(odometer->w + i + 1) = *(odometer->w + i) * *(*(grid->weights + i) + j);
     }
 
-    const double dv = delta(intervals, d);
-    unsigned int radix = 0;
-    *res = 0.;
-    while (inbounds(intervals, radix, d)) {
+}
 
-        if (xvalue(intervals, rules, radix, d, x) == -1) {
-            free(rules); free(x);
-            res = NULL;
-            return -1;
-        }
+/**
+ * Moves an odometer to the domain element with a given flattened index, the last axis varying fastest.
+ * The weight of the domain element is `odometer->w[grid->d]`.
+ */
+void seek_odometer(struct Grid *grid, struct Odometer *odometer, uint64_t radix) {
+
+    for (int i = grid->d - 1; i >= 0; --i) {
+        *(odometer->index + i) = (unsigned int)(radix % *(grid->sizes + i));
+        radix /= *(grid->sizes + i);
+    }
+    refresh(grid, odometer, 0);
+
+}
 
-        *res += dv * eval(f, x, d);
-        radix = increment(intervals, radix, d);
+/**
+ * Moves an odometer to the next domain element, wrapping around after the last.
+ */
+void step_odometer(struct Grid *grid, struct Odometer *odometer) {
 
+    int i = grid->d - 1;
+    for (; i >= 0; --i) {
+        if (++*(odometer->index + i) < *(grid->sizes + i)) { break; }
+        *(odometer->index + i) = 0;
     }
+    refresh(grid, odometer, i < 0 ? 0 : i);
+
+}
+
+/**
+ * Accumulates the weighted values of a mathematical function of several real variables over a block
+ * of domain elements.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param block The row-major array of `N` domain elements at which to evaluate `f`
+ * @param weights The weight of each domain element in `block`
+ * @param N The number of domain elements in `block`
+ * @param d The number of dimensions in the domain of `f`
+ * @param values A scratch array of at least `N * f->outputs` elements
+ * @param r The reducers to which to add the weighted values of `f`, one per value of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short accumulate(
+    struct Function *f, double *block, double *weights, Py_ssize_t N, unsigned int d,
+    double *values, struct Reducer *r
+) {
 
-    free(rules); free(x);
+    const unsigned int m = f->outputs;
+    if (eval_block(f, block, N, d, values) == -1) { return -1; }
+    for (Py_ssize_t k = 0; k < N; ++k) {
+        for (unsigned int j = 0; j < m; ++j) { reducer_add(r + j, *(weights + k) * *(values + k * m + j)); }
+    }
 
     return 0;
 
 }
 
-short trapezoidal(PyObject *f, struct Interval **intervals, unsigned int d, double *res) {
+/**
+ * The shared state of a sum computed in parallel over chunks of the flattened index space. Each chunk
+ * is reduced separately, and the chunks are merged in order, so that the result does not depend on
+ * the number of threads.
+ */
+struct SumTask {
+    struct Function *f;
+    struct Grid *grid;
+    uint64_t chunksize;
+    size_t first;
+    struct Reducer *reducers;
+    short failed;
+};
 
-    RiemannRule *rules = (RiemannRule *)calloc(d, sizeof(RiemannRule));
-    double *x = (double *)calloc(d, sizeof(double));
-    if (!rules || !x) {
-        free(rules); free(x);
-        res = NULL;
-        return -1;
+/**
+ * Reduces the weighted values of a native function over one chunk of the current batch.
+ */
+static void sum_chunk(void *context, unsigned int worker, size_t chunk) {
+
+    struct SumTask *task = (struct SumTask *)context;
+    struct Grid *grid = task->grid;
+    struct Reducer *r = task->reducers + chunk;
+    const unsigned int d = grid->d;
+
+    reducer_init(r);
+
+    struct Odometer *odometer = new_odometer(grid);
+    if (!odometer) {
+        task->failed = 1;
+        return;
     }
-    for (int i = 0; i < d; ++i) { *(rules + i) = endpoint; }
 
-    const double dv = delta(intervals, d);
-    const unsigned int nlegs = 2 << d;
-    unsigned int nborders;
-    unsigned int radix = 0;
+    uint64_t lo = (uint64_t)(task->first + chunk) * task->chunksize;
+    uint64_t count = grid->npoints - lo < task->chunksize ? grid->npoints - lo : task->chunksize;
+    seek_odometer(grid, odometer, lo);
+    for (uint64_t k = 0; k < count; ++k) {
+        reducer_add(r, *(odometer->w + d) * task->f->native(odometer->x, d, task->f->userdata));
+        step_odometer(grid, odometer);
+    }
 
-    *res = 0.;
+    free_odometer(odometer);
 
-    while (inbounds(intervals, radix, d)) {
+}
+
+/**
+ * Computes a sum over a tensor-product grid on multiple threads. Only native functions are supported,
+ * as the GIL is released for the whole computation. Chunks span a power-of-two number of reducer
+ * leaves, so the result is bit-identical to the serial sum. Chunks span at most `SUM_CHUNK_MAX`
+ * domain elements and run in batches of `SUM_BATCH` chunks per thread, with signals checked between
+ * batches, so that long sums can be interrupted.
+ */
+static short parallel_sum(struct Function *f, struct Grid *grid, unsigned int nthreads, double *res) {
+
+    struct SumTask task = { .f = f, .grid = grid, .chunksize = LEAF_SIZE, .failed = 0 };
+    while (grid->npoints / task.chunksize > 16 * nthreads && task.chunksize < SUM_CHUNK_MAX) {
+        task.chunksize *= 2;
+    }
+
+    const size_t nchunks = (size_t)((grid->npoints + task.chunksize - 1) / task.chunksize);
+    const size_t batch = nchunks < (size_t)SUM_BATCH * nthreads ? nchunks : (size_t)SUM_BATCH * nthreads;
+    struct Reducer *r = (struct Reducer *)malloc(sizeof(struct Reducer));
+    if (!r || !(task.reducers = (struct Reducer *)malloc((batch ? batch : 1) * sizeof(struct Reducer)))) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(r);
+        return -1;
+    }
+    reducer_init(r);
 
-        if (xvalue(intervals, rules, radix, d, x) == -1) {
-            free(rules); free(x);
-            res = NULL;
+    for (task.first = 0; task.first < nchunks; task.first += batch) {
+
+        const size_t count = nchunks - task.first < batch ? nchunks - task.first : batch;
+        if (parallel_for(nthreads, count, sum_chunk, &task) == -1) {
+            free(r); free(task.reducers);
             return -1;
         }
-
-        nborders = 0;
-        for (int i = 0; i < d; ++i) {
-            if (*(x + i) == (*(intervals + i))->lower || *(x + i) == (*(intervals + i))->upper) {
-                ++nborders;
-            }
+        if (task.failed) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            free(r); free(task.reducers);
+            return -1;
+        }
+        for (size_t i = 0; i < count; ++i) { reducer_merge(r, task.reducers + i); }
+        if (PyErr_CheckSignals() == -1) {
+            free(r); free(task.reducers);
+            return -1;
         }
-
-        *res += dv * (1 << (d - nborders)) * eval(f, x, d) / nlegs;
-        radix = increment(intervals, radix, d);
 
     }
-    
-    free(rules); free(x);
+    *res = reducer_result(r);
+    free(r); free(task.reducers);
 
     return 0;
 
 }
 
-static PyObject *integral_delta(PyObject *self, PyObject *args) {
+/**
+ * Computes a weighted sum of the values of a mathematical function of several real variables over a
+ * tensor-product grid of domain elements, in blocks of `f->blocksize` elements. The result is
+ * bit-identical for any block size and number of threads. Functions with several values are summed
+ * into one sum per value in the same traversal.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param grid The grid of domain elements and weights
+ * @param nthreads The number of threads to use if `f` is native
+ * @param res The location to which to write the `f->outputs` sums
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short tensor_sum(struct Function *f, struct Grid *grid, unsigned int nthreads, double *res) {
 
-    PyObject *ob_intervals;
-    if (!PyArg_ParseTuple(args, "OI", &ob_intervals)) { return NULL; }
+    if (f->type == NATIVE && nthreads > 1) { return parallel_sum(f, grid, nthreads, res); }
 
-    if (!PySequence_Check(ob_intervals)) {
-        PyErr_SetString(PyExc_TypeError, "Expected a sequence of 'Interval' objects");
-        return NULL;
+    const unsigned int d = grid->d, m = f->outputs;
+    const Py_ssize_t N = f->blocksize;
+    double *block = (double *)calloc(N * d, sizeof(double));
+    double *weights = (double *)calloc(N, sizeof(double));
+    double *values = (double *)calloc(N * m, sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc(m * sizeof(struct Reducer));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!block || !weights || !values || !r || !odometer) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
     }
+    for (unsigned int j = 0; j < m; ++j) { reducer_init(r + j); }
 
-    unsigned int d;
-    struct Interval **intervals = parse_intervals(ob_intervals, &d);
-    if (!intervals) { return NULL; }
+    Py_ssize_t k = 0;
+    seek_odometer(grid, odometer, 0);
+    for (uint64_t radix = 0; radix < grid->npoints; ++radix) {
 
-    double result = delta(intervals, d);
+        memcpy(block + k * d, odometer->x, d * sizeof(double));
+        *(weights + k) = *(odometer->w + d);
+        step_odometer(grid, odometer);
 
-    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
-    free(intervals);
+        if (++k == N) {
+            if (accumulate(f, block, weights, N, d, values, r) == -1) {
+                free(block); free(weights); free(values); free(r); free_odometer(odometer);
+                return -1;
+            }
+            k = 0;
+        }
 
-    return PyFloat_FromDouble(result);
+    }
+    if (k && accumulate(f, block, weights, k, d, values, r) == -1) {
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
+    }
+    for (unsigned int j = 0; j < m; ++j) { *(res + j) = reducer_result(r + j); }
 
-}
+    free(block); free(weights); free(values); free(r); free_odometer(odometer);
 
-static PyObject *riemann_rule(PyObject *self, PyObject *args, RiemannRule rule) {
+    return 0;
 
-    PyObject *ob_interval;
-    unsigned int i;
-    if (!PyArg_ParseTuple(args, "OI", &ob_interval, &i)) { return NULL; }
+}
 
-    struct Interval *interval = parse_interval(ob_interval);
-    double *x = (double *)malloc(sizeof(double));
-    if (!interval || !x) {
+/**
+ * Builds the grid of a Riemann sum, with the domain elements along each interval given by a rule.
+ */
+struct Grid *riemann_grid(struct Interval **intervals, enum RiemannRules *rrules, unsigned int d) {
+
+    RiemannRule *rules = (RiemannRule *)calloc(d, sizeof(RiemannRule));
+    if (!rules) {
         PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
-        free(interval); free(x);
         return NULL;
     }
+    
+    for (unsigned int i = 0; i < d; ++i) {
+        switch (*(rrules + i)) {
+            case LEFT:
+                *(rules + i) = left;
+                break;
+            case RIGHT:
+                *(rules + i) = right;
+                break;
+            case MIDPOINT:
+                *(rules + i) = midpoint;
+                break;
+            default:
+                PyErr_SetString(PyExc_ValueError, "Invalid Riemann rule");
+                free(rules);
+                return NULL;
+        }
+    }
 
-    short err = rule(interval, i, x);
-    if (err < 0) {
-        PyErr_SetString(PyExc_ValueError, "Index of bounds of interval");
-        free(interval); free(x);
+    struct Grid *grid = build_grid(intervals, rules, d, 0);
+    free(rules);
+
+    return grid;
+
+}
+
+/**
+ * Builds the grid of the trapezoidal rule, including both endpoints of each interval.
+ */
+struct Grid *trapezoidal_grid(struct Interval **intervals, unsigned int d) {
+
+    RiemannRule *rules = (RiemannRule *)calloc(d, sizeof(RiemannRule));
+    if (!rules) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
         return NULL;
     }
+    for (int i = 0; i < d; ++i) { *(rules + i) = endpoint; }
 
-    PyObject *res = PyFloat_FromDouble(*x);
-    free(interval); free(x);
+    struct Grid *grid = build_grid(intervals, rules, d, 1);
+    free(rules);
 
-    return res;
+    return grid;
 
 }
 
-static PyObject *integral_endpoint(
-    PyObject *self, PyObject *args
-) { return riemann_rule(self, args, endpoint); }
-
-static PyObject *integral_left(
-    PyObject *self, PyObject *args
-) { return riemann_rule(self, args, left); }
+short riemann(
+    struct Function *f, struct Interval **intervals, enum RiemannRules *rrules, unsigned int d,
+    unsigned int nthreads, double *res
+) {
 
-static PyObject *integral_right(
-    PyObject *self, PyObject *args
-) { return riemann_rule(self, args, right); }
+    struct Grid *grid = riemann_grid(intervals, rrules, d);
+    if (!grid) { return -1; }
 
-static PyObject *integral_midpoint(
-    PyObject *self, PyObject *args
-) { return riemman_rule(self, args, midpoint); }
+    short err = tensor_sum(f, grid, nthreads, res);
+    free_grid(grid);
 
-static PyObject *integral_riemann(PyObject *self, PyObject *args) {
+    return err;
 
-    PyObject *ob_f;
-    PyObject *ob_intervals;
-    PyObject *ob_rrules;
-    if (!PyArg_ParseTuple(args, "OOO", &ob_f, &ob_intervals, &ob_rrules)) { return NULL; }
+}
 
-    unsigned int d;
-    PyObject *f = parse_function(ob_f);
-    struct Interval **intervals = parse_intervals(ob_intervals, &d);
-    enum RiemannRules *rrules = parse_rrules(ob_rrules);
-    double *res = (double *)malloc(sizeof(double));
-    if (!f || !intervals || !rrules || !res) {
-        for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
-        free(f); free(intervals); free(rrules); free(res);
-    }
+short trapezoidal(
+    struct Function *f, struct Interval **intervals, unsigned int d, unsigned int nthreads,
+    double *res
+) {
 
-    PyObject *value = (
-        riemann(f, intervals, rrules, d, res) ? NULL : PyFloat_FromDouble(*res)
-    );
+    struct Grid *grid = trapezoidal_grid(intervals, d);
+    if (!grid) { return -1; }
 
-    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
-    free(f); free(intervals); free(rrules); free(res);
+    short err = tensor_sum(f, grid, nthreads, res);
+    free_grid(grid);
 
-    return value;
+    return err;
 
 }
 
-static PyObject *integral_trapezoidal(PyObject *self, PyObject *args) {
+/**
+ * Abscissae and weights of the 15-point Kronrod extension of the 7-point Gauss-Legendre rule on
+ * `[-1, 1]`, from QUADPACK. Kronrod abscissae are listed from the outermost to the center; Gauss
+ * weights correspond to the Kronrod abscissae with odd indices.
+ */
+static const double xgk15[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000
+};
+static const double wgk15[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double wg7[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
 
-    PyObject *ob_f;
-    PyObject *ob_intervals;
-    if (!PyArg_ParseTuple(args, "OO", &ob_f, &ob_intervals)) { return NULL; }
+/**
+ * Abscissae and weights of the 21-point Kronrod extension of the 10-point Gauss-Legendre rule on
+ * `[-1, 1]`, from QUADPACK.
+ */
+static const double xgk21[11] = {
+    0.995657163025808080735527280689003, 0.973906528517171720077964012084452,
+    0.930157491355708226001207180059508, 0.865063366688984510732096688423493,
+    0.780817726586416897063717578345042, 0.679409568299024406234327365114874,
+    0.562757134668604683339000099272694, 0.433395394129247190799265943165784,
+    0.294392862701460198131126603103866, 0.148874338981631210884826001129720,
+    0.000000000000000000000000000000000
+};
+static const double wgk21[11] = {
+    0.011694638867371874278064396062192, 0.032558162307964727478818972459390,
+    0.054755896574351996031381300244580, 0.075039674810919952767043140916190,
+    0.093125454583697605535065465083366, 0.109387158802297641899210590325805,
+    0.123491976262065851077208745585407, 0.134709217311473325928054001771707,
+    0.142775938577060080797094273138717, 0.147739104901338491374841515972068,
+    0.149445554002916905664936468389821
+};
+static const double wg10[5] = {
+    0.066671344308688137593568809893332, 0.149451349150580593145776339657697,
+    0.219086362515982043995534934228163, 0.269266719309996355091226921569469,
+    0.295524224714752870173892994651338
+};
+
+static const struct KronrodRule gk15 = { 8, xgk15, wgk15, wg7 };
+static const struct KronrodRule gk21 = { 11, xgk21, wgk21, wg10 };
+
+/**
+ * A subinterval of an adaptive quadrature, with its integral and error estimates.
+ */
+struct Segment {
+    double a;
+    double b;
+    double value;
+    double error;
+};
 
+/**
+ * The state of an adaptive quadrature nested over the axes of the domain. Each axis has its own
+ * scratch space for the values and error estimates at the abscissae of the Kronrod rule.
+ */
+struct Quadrature {
+    struct Function *f;
+    struct Interval **intervals;
     unsigned int d;
-    PyObject *f = parse_function(ob_f);
-    struct Interval **intervals = parse_intervals(ob_intervals, &d);
-    double *res = (double *)malloc(sizeof(double));
-    if(!f || !intervals || !res) {
-        for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
-        free(f); free(intervals); free(res);
+    const struct KronrodRule *rule;
+    double *epsabs;
+    double epsrel;
+    unsigned int limit;
+    double *x;
+    double *block;
+    double *values;
+    double *errors;
+    uint64_t neval;
+};
+
+static short adapt(struct Quadrature *q, unsigned int axis, double *value, double *error);
+
+/**
+ * Applies a Gauss-Kronrod rule to a subinterval along an axis. Along the innermost axis, `f` is
+ * evaluated at all the abscissae in one block; along outer axes, the integrand is the adaptive
+ * quadrature over the inner axes, whose error estimates are propagated into that of the segment.
+ * As in QUADPACK, the error is floored at the roundoff level of the integral of `|f|`.
+ *
+ * @param q The state of the quadrature
+ * @param axis The axis along which to integrate
+ * @param seg The segment whose bounds to integrate over, and to which to write the estimates
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short kronrod(struct Quadrature *q, unsigned int axis, struct Segment *seg) {
+
+    const struct KronrodRule *rule = q->rule;
+    const unsigned int n = rule->n, npoints = 2 * n - 1, d = q->d;
+    const double c = (seg->a + seg->b) / 2, h = (seg->b - seg->a) / 2;
+    double *fv = q->values + axis * npoints;
+    double *ev = q->errors + axis * npoints;
+
+    for (unsigned int k = 0; k < npoints; ++k) {
+        const double dx = k == 0 ? 0. : h * *(rule->xgk + (k - 1) / 2);
+        *(q->x + axis) = k % 2 ? c - dx : c + dx;
+        if (axis == d - 1) {
+            memcpy(q->block + k * d, q->x, d * sizeof(double));
+        } else if (adapt(q, axis + 1, fv + k, ev + k) == -1) {
+            return -1;
+        }
+    }
+    if (axis == d - 1) {
+        if (eval_block(q->f, q->block, npoints, d, fv) == -1) { return -1; }
+        q->neval += npoints;
+        memset(ev, 0, npoints * sizeof(double));
     }
 
-    PyObject *value = (
-        trapezoidal(f, intervals, d, res) ? NULL : PyFloat_FromDouble(*res)
-    );
+    const double fc = *fv;
+    double resk = *(rule->wgk + n - 1) * fc;
+    double resg = (n - 1) % 2 ? *(rule->wg + (n - 1) / 2) * fc : 0.;
+    double resabs = fabs(resk), inner = *(rule->wgk + n - 1) * *ev;
+    for (unsigned int j = 0; j < n - 1; ++j) {
+        const double f1 = *(fv + 2 * j + 1), f2 = *(fv + 2 * j + 2);
+        resk += *(rule->wgk + j) * (f1 + f2);
+        resabs += *(rule->wgk + j) * (fabs(f1) + fabs(f2));
+        inner += *(rule->wgk + j) * (*(ev + 2 * j + 1) + *(ev + 2 * j + 2));
+        if (j % 2) { resg += *(rule->wg + j / 2) * (f1 + f2); }
+    }
 
-    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
-    free(f); free(intervals); free(res);
+    const double mean = resk / 2;
+    double resasc = *(rule->wgk + n - 1) * fabs(fc - mean);
+    for (unsigned int j = 0; j < n - 1; ++j) {
+        resasc += *(rule->wgk + j) * (fabs(*(fv + 2 * j + 1) - mean) + fabs(*(fv + 2 * j + 2) - mean));
+    }
+    resasc *= fabs(h);
 
-    return value;
+    double error = fabs((resk - resg) * h);
+    if (resasc != 0. && error != 0.) {
+        const double scale = pow(200 * error / resasc, 1.5);
+        error = resasc * (scale < 1. ? scale : 1.);
+    }
+    resabs *= fabs(h);
+    if (resabs > DBL_MIN / (50 * DBL_EPSILON) && 50 * DBL_EPSILON * resabs > error) {
+        error = 50 * DBL_EPSILON * resabs;
+    }
+
+    seg->value = resk * h;
+    seg->error = error + fabs(h) * inner;
+
+    return 0;
+
+}
+
+/**
+ * Restores the max-heap order of segments by error estimate, sifting down from index `i`.
+ */
+static void sift_down(struct Segment *heap, unsigned int size, unsigned int i) {
+
+    for (;;) {
+        unsigned int largest = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < size && (heap + l)->error > (heap + largest)->error) { largest = l; }
+        if (r < size && (heap + r)->error > (heap + largest)->error) { largest = r; }
+        if (largest == i) { return; }
+        struct Segment temp = *(heap + i);
+        *(heap + i) = *(heap + largest), *(heap + largest) = temp;
+        i = largest;
+    }
+
+}
+
+/**
+ * Restores the max-heap order of segments by error estimate, sifting up from index `i`.
+ */
+static void sift_up(struct Segment *heap, unsigned int i) {
+
+    while (i > 0 && (heap + (i - 1) / 2)->error < (heap + i)->error) {
+        struct Segment temp = *(heap + i);
+        *(heap + i) = *(heap + (i - 1) / 2), *(heap + (i - 1) / 2) = temp;
+        i = (i - 1) / 2;
+    }
+
+}
+
+/**
+ * Integrates over the axes from `axis` onward by globally adaptive bisection, always bisecting the
+ * subinterval with the largest error estimate.
+ *
+ * @param q The state of the quadrature
+ * @param axis The outermost axis to integrate along
+ * @param value The location to which to write the integral estimate
+ * @param error The location to which to write the error estimate
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short adapt(struct Quadrature *q, unsigned int axis, double *value, double *error) {
+
+    struct Interval *interval = *(q->intervals + axis);
+    struct Segment *heap = (struct Segment *)malloc(q->limit * sizeof(struct Segment));
+    if (!heap) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return -1;
+    }
+
+    heap->a = interval->lower, heap->b = interval->upper;
+    if (kronrod(q, axis, heap) == -1) {
+        free(heap);
+        return -1;
+    }
+    unsigned int size = 1;
+    double total = heap->value, err = heap->error;
+
+    while (size < q->limit) {
+
+        const double tol = *(q->epsabs + axis) > q->epsrel * fabs(total) ? *(q->epsabs + axis) : q->epsrel * fabs(total);
+        if (err <= tol) { break; }
+
+        struct Segment worst = *heap;
+        const double m = (worst.a + worst.b) / 2;
+        if (!(worst.a < m && m < worst.b)) { break; }
+
+        struct Segment left = { worst.a, m, 0., 0. }, right = { m, worst.b, 0., 0. };
+        if (kronrod(q, axis, &left) == -1 || kronrod(q, axis, &right) == -1) {
+            free(heap);
+            return -1;
+        }
+
+        total += left.value + right.value - worst.value;
+        err += left.error + right.error - worst.error;
+
+        *heap = left;
+        sift_down(heap, size, 0);
+        *(heap + size) = right;
+        sift_up(heap, size++);
+
+    }
+
+    total = 0., err = 0.;
+    for (unsigned int i = 0; i < size; ++i) { total += (heap + i)->value, err += (heap + i)->error; }
+    *value = total, *error = err;
+
+    free(heap);
+
+    return 0;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables over a box by adaptive Gauss-Kronrod
+ * quadrature, nested over the axes of the box. The number of subintervals of each interval is ignored.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param epsabs The absolute error tolerance
+ * @param epsrel The relative error tolerance
+ * @param krule The Gauss-Kronrod rule to use
+ * @param limit The maximum number of subintervals per adaptive quadrature
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @param neval The location to which to write the number of evaluations of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short quad(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    enum KronrodRules krule, unsigned int limit, double *res, double *err, uint64_t *neval
+) {
+
+    const struct KronrodRule *rule;
+    switch (krule) {
+        case GK15:
+            rule = &gk15;
+            break;
+        case GK21:
+            rule = &gk21;
+            break;
+        default:
+            PyErr_SetString(PyExc_ValueError, "Invalid Gauss-Kronrod rule");
+            return -1;
+    }
+    if (d == 0 || limit == 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected at least one interval and subinterval");
+        return -1;
+    }
+    if (bounded(intervals, d) == -1) { return -1; }
+
+    const unsigned int npoints = 2 * rule->n - 1;
+    struct Quadrature q = {
+        .f = f, .intervals = intervals, .d = d, .rule = rule, .epsrel = epsrel, .limit = limit,
+        .epsabs = (double *)calloc(d, sizeof(double)),
+        .x = (double *)calloc(d, sizeof(double)),
+        .block = (double *)calloc(npoints * d, sizeof(double)),
+        .values = (double *)calloc(npoints * d, sizeof(double)),
+        .errors = (double *)calloc(npoints * d, sizeof(double)),
+        .neval = 0
+    };
+    if (!q.epsabs || !q.x || !q.block || !q.values || !q.errors) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(q.epsabs); free(q.x); free(q.block); free(q.values); free(q.errors);
+        return -1;
+    }
+
+    *q.epsabs = epsabs;
+    for (unsigned int i = 1; i < d; ++i) {
+        const double width = fabs((*(intervals + i - 1))->upper - (*(intervals + i - 1))->lower);
+        *(q.epsabs + i) = width > 0. ? *(q.epsabs + i - 1) / (2 * width) : *(q.epsabs + i - 1);
+    }
+
+    short status = adapt(&q, 0, res, err);
+    *neval = q.neval;
+
+    free(q.epsabs); free(q.x); free(q.block); free(q.values); free(q.errors);
+
+    return status;
+
+}
+
+/**
+ * Sums the weighted values of a mathematical function of several real variables over the domain
+ * elements of a grid that have an odd index along at least one axis, or over all of them if `all` is
+ * set. These are the domain elements added by halving every subinterval of a coarser grid.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param grid The grid of domain elements and weights
+ * @param all Whether to include the domain elements of the coarser grid
+ * @param res The location to which to write the sum
+ * @param count The location to which to write the number of evaluations of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short refinement_sum(
+    struct Function *f, struct Grid *grid, short all, double *res, uint64_t *count
+) {
+
+    const unsigned int d = grid->d;
+    const Py_ssize_t N = f->blocksize;
+    double *block = (double *)calloc(N * d, sizeof(double));
+    double *weights = (double *)calloc(N, sizeof(double));
+    double *values = (double *)calloc(N, sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc(sizeof(struct Reducer));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!block || !weights || !values || !r || !odometer) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
+    }
+    reducer_init(r);
+
+    Py_ssize_t k = 0;
+    *count = 0;
+    seek_odometer(grid, odometer, 0);
+    for (uint64_t radix = 0; radix < grid->npoints; ++radix, step_odometer(grid, odometer)) {
+
+        short odd = all;
+        for (unsigned int i = 0; i < d && !odd; ++i) { odd = *(odometer->index + i) % 2; }
+        if (!odd) { continue; }
+
+        memcpy(block + k * d, odometer->x, d * sizeof(double));
+        *(weights + k) = *(odometer->w + d);
+        ++*count;
+
+        if (++k == N) {
+            if (accumulate(f, block, weights, N, d, values, r) == -1) {
+                free(block); free(weights); free(values); free(r); free_odometer(odometer);
+                return -1;
+            }
+            k = 0;
+        }
+
+    }
+    if (k && accumulate(f, block, weights, k, d, values, r) == -1) {
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
+    }
+    *res = reducer_result(r);
+
+    free(block); free(weights); free(values); free(r); free_odometer(odometer);
+
+    return 0;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables by Romberg's method. Starting from
+ * the trapezoidal rule with the subintervals of each interval, every level halves all subintervals
+ * and evaluates `f` only at the new domain elements, reusing the sum over the previous level. The
+ * trapezoidal estimates are extrapolated by Richardson's method until the difference between the last
+ * two diagonal entries of the table meets the tolerance.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param epsabs The absolute error tolerance
+ * @param epsrel The relative error tolerance
+ * @param maxlevel The maximum number of halvings
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @param neval The location to which to write the number of evaluations of `f`
+ * @param nreused The location to which to write the number of evaluations reused from coarser levels
+ * @return `0` upon success, or `-1` upon failure
+ */
+short romberg(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    unsigned int maxlevel, double *res, double *err, uint64_t *neval, uint64_t *nreused
+) {
+
+    struct Interval *refined = (struct Interval *)calloc(d, sizeof(struct Interval));
+    struct Interval **prefined = (struct Interval **)calloc(d, sizeof(struct Interval *));
+    double *table = (double *)calloc(2 * (maxlevel + 1), sizeof(double));
+    if (!refined || !prefined || !table) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(refined); free(prefined); free(table);
+        return -1;
+    }
+    for (unsigned int i = 0; i < d; ++i) {
+        *(refined + i) = **(intervals + i);
+        *(prefined + i) = refined + i;
+    }
+
+    double *prev = table, *curr = table + maxlevel + 1;
+    double trapezoid = 0.;
+    uint64_t npoints = 0;
+    *neval = 0, *nreused = 0, *err = INFINITY;
+
+    for (unsigned int level = 0; level <= maxlevel; ++level) {
+
+        if (level) {
+            for (unsigned int i = 0; i < d; ++i) {
+                if ((refined + i)->n > UINT_MAX / 2) {
+                    PyErr_SetString(PyExc_OverflowError, "Too many subintervals in grid");
+                    free(refined); free(prefined); free(table);
+                    return -1;
+                }
+                (refined + i)->n *= 2;
+            }
+        }
+
+        struct Grid *grid = trapezoidal_grid(prefined, d);
+        if (!grid) {
+            free(refined); free(prefined); free(table);
+            return -1;
+        }
+
+        double sum;
+        uint64_t count;
+        short status = refinement_sum(f, grid, level == 0, &sum, &count);
+        free_grid(grid);
+        if (status == -1) {
+            free(refined); free(prefined); free(table);
+            return -1;
+        }
+
+        trapezoid = level ? ldexp(trapezoid, -(int)d) + sum : sum;
+        *nreused += npoints, npoints += count, *neval += count;
+
+        *curr = trapezoid;
+        for (unsigned int j = 1; j <= level; ++j) {
+            *(curr + j) = *(curr + j - 1) + (*(curr + j - 1) - *(prev + j - 1)) / (ldexp(1., 2 * j) - 1);
+        }
+        *res = *(curr + level);
+
+        if (level) {
+            *err = fabs(*(curr + level) - *(prev + level - 1));
+            if (*err <= (epsabs > epsrel * fabs(*res) ? epsabs : epsrel * fabs(*res))) { break; }
+        }
+
+        double *temp = prev;
+        prev = curr, curr = temp;
+
+    }
+
+    free(refined); free(prefined); free(table);
+
+    return 0;
+
+}
+
+/**
+ * Computes a node and weight of the double-exponential rule of an interval at a step abscissa `t`:
+ * the tanh-sinh rule for a finite interval, the exp-sinh rule for a half-infinite interval and the
+ * sinh-sinh rule for the real line. Nodes near finite endpoints are computed from their distance to
+ * the endpoint, to resolve endpoint singularities.
+ *
+ * @param interval An interval with `lower < upper`
+ * @param t The step abscissa
+ * @param x The location to which to write the node
+ * @param w The location to which to write the weight
+ * @return `0` if the node is usable, or `-1` if it coincides with an endpoint or its weight vanishes
+ */
+static short de_node(struct Interval *interval, double t, double *x, double *w) {
+
+    const double a = interval->lower, b = interval->upper;
+    const double u = M_PI_2 * sinh(t), du = M_PI_2 * cosh(t);
+
+    if (isfinite(a) && isfinite(b)) {
+        const double half = (b - a) / 2, e = exp(-2 * fabs(u)), gap = 2 * half * e / (1 + e);
+        *x = t < 0 ? a + gap : b - gap;
+        *w = half * du * 4 * e / ((1 + e) * (1 + e));
+    } else if (isfinite(a)) {
+        *x = a + exp(u), *w = du * exp(u);
+    } else if (isfinite(b)) {
+        *x = b - exp(u), *w = du * exp(u);
+    } else {
+        *x = sinh(u), *w = du * cosh(u);
+    }
+
+    return isfinite(*x) && isfinite(*w) && *w > 0. && *x != a && *x != b ? 0 : -1;
+
+}
+
+/**
+ * The state of a nested double-exponential integration.
+ */
+struct DoubleExponential {
+    struct Function *f;
+    struct Interval **intervals;
+    unsigned int d;
+    double *epsabs;
+    double epsrel;
+    unsigned int maxlevel;
+    double *x;
+    double *block;
+    double *weights;
+    long *steps;
+    double *values;
+    uint64_t neval;
+};
+
+/**
+ * Evaluates the pending domain elements of a double-exponential integration and adds their weighted
+ * values to a sum, also recording each weighted value by its step index if `terms` is not `NULL`.
+ */
+static short de_flush(struct DoubleExponential *de, Py_ssize_t k, double *terms, double *sum) {
+
+    if (eval_block(de->f, de->block, k, de->d, de->values) == -1) { return -1; }
+    for (Py_ssize_t i = 0; i < k; ++i) {
+        const double term = *(de->weights + i) * *(de->values + i);
+        *sum += term;
+        if (terms) { *(terms + *(de->steps + i)) = term; }
+    }
+    de->neval += k;
+
+    return 0;
+
+}
+
+/**
+ * Integrates along one axis by double-exponential levels, halving the step at each level and only
+ * adding the new step abscissae, until successive estimates agree to the tolerance of the axis. The
+ * integrand along the axis is `f` for the last axis, or the integral over the following axes. After
+ * the first level, step abscissae beyond the outermost terms that are not negligible are dropped.
+ *
+ * @param de The state of the integration
+ * @param axis The axis along which to integrate
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short de_axis(struct DoubleExponential *de, unsigned int axis, double *res, double *err) {
+
+    struct Interval interval = **(de->intervals + axis);
+    const unsigned int d = de->d;
+    double sign = 1.;
+    if (interval.lower > interval.upper) {
+        const double temp = interval.lower;
+        interval.lower = interval.upper, interval.upper = temp, sign = -1.;
+    }
+    *res = 0., *err = 0.;
+    if (interval.lower == interval.upper) { return 0; }
+
+    const long jmax = (long)DE_TMAX;
+    double terms[2 * (long)DE_TMAX + 1] = { 0. };
+    double tlo = -DE_TMAX, thi = DE_TMAX;
+    double sum = 0., inner = 0., previous = 0.;
+
+    for (unsigned int level = 0; level <= de->maxlevel; ++level) {
+
+        const double h = ldexp(1., -(int)level);
+        Py_ssize_t k = 0;
+
+        for (long j = (long)ceil(tlo / h); j * h <= thi; ++j) {
+
+            if (level && j % 2 == 0) { continue; }
+
+            double xj, wj;
+            if (de_node(&interval, j * h, &xj, &wj) == -1) { continue; }
+            *(de->x + axis) = xj;
+
+            if (axis + 1 < d) {
+                double value, error;
+                if (de_axis(de, axis + 1, &value, &error) == -1) { return -1; }
+                sum += wj * value, inner += wj * error;
+                if (!level) { terms[j + jmax] = wj * value; }
+                continue;
+            }
+
+            memcpy(de->block + k * d, de->x, d * sizeof(double));
+            *(de->weights + k) = wj, *(de->steps + k) = j;
+            if (++k == de->f->blocksize) {
+                if (de_flush(de, k, level ? NULL : terms + jmax, &sum) == -1) { return -1; }
+                k = 0;
+            }
+
+        }
+        if (k && de_flush(de, k, level ? NULL : terms + jmax, &sum) == -1) { return -1; }
+
+        if (!level) {
+            long lo = -jmax, hi = jmax;
+            while (lo < 0 && fabs(terms[lo + jmax]) <= DBL_EPSILON * fabs(sum)) { ++lo; }
+            while (hi > 0 && fabs(terms[hi + jmax]) <= DBL_EPSILON * fabs(sum)) { --hi; }
+            tlo = lo > -jmax ? lo - 1 : -DE_TMAX, thi = hi < jmax ? hi + 1 : DE_TMAX;
+        }
+
+        *res = sign * h * sum;
+        if (level) {
+            const double change = fabs(*res - previous);
+            const double tol = *(de->epsabs + axis) > de->epsrel * fabs(*res)
+                ? *(de->epsabs + axis) : de->epsrel * fabs(*res);
+            *err = change + h * inner;
+            if (change <= tol) { break; }
+        }
+        previous = *res;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables by double-exponential quadrature,
+ * nested along each axis. Each interval may be finite, half-infinite or the real line, and integrable
+ * singularities at finite endpoints are handled. Along each axis, the step is halved until successive
+ * estimates agree to within the tolerance, reusing all the domain elements of the coarser steps.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param epsabs The absolute error tolerance
+ * @param epsrel The relative error tolerance
+ * @param maxlevel The maximum number of step halvings along each axis
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @param neval The location to which to write the number of evaluations of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short tanhsinh(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    unsigned int maxlevel, double *res, double *err, uint64_t *neval
+) {
+
+    if (d == 0 || maxlevel > DE_MAX_LEVEL) {
+        PyErr_Format(
+            PyExc_ValueError, "Expected at least one interval and a maximum level of at most %d", DE_MAX_LEVEL
+        );
+        return -1;
+    }
+    for (unsigned int i = 0; i < d; ++i) {
+        if (isnan((*(intervals + i))->lower) || isnan((*(intervals + i))->upper)) {
+            PyErr_SetString(PyExc_ValueError, "Expected interval bounds that are not NaN");
+            return -1;
+        }
+    }
+
+    struct DoubleExponential de = {
+        .f = f, .intervals = intervals, .d = d, .epsrel = epsrel, .maxlevel = maxlevel, .neval = 0,
+        .epsabs = (double *)calloc(d, sizeof(double)),
+        .x = (double *)calloc(d, sizeof(double)),
+        .block = (double *)calloc(f->blocksize * d, sizeof(double)),
+        .weights = (double *)calloc(f->blocksize, sizeof(double)),
+        .steps = (long *)calloc(f->blocksize, sizeof(long)),
+        .values = (double *)calloc(f->blocksize, sizeof(double))
+    };
+    if (!de.epsabs || !de.x || !de.block || !de.weights || !de.steps || !de.values) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(de.epsabs); free(de.x); free(de.block); free(de.weights); free(de.steps); free(de.values);
+        return -1;
+    }
+
+    *de.epsabs = epsabs;
+    for (unsigned int i = 1; i < d; ++i) {
+        const double width = fabs((*(intervals + i - 1))->upper - (*(intervals + i - 1))->lower);
+        *(de.epsabs + i) = (
+            width > 0. && isfinite(width) ? *(de.epsabs + i - 1) / (2 * width) : *(de.epsabs + i - 1)
+        );
+    }
+
+    short status = de_axis(&de, 0, res, err);
+    *neval = de.neval;
+
+    free(de.epsabs); free(de.x); free(de.block); free(de.weights); free(de.steps); free(de.values);
+
+    return status;
+
+}
+
+/**
+ * Advances a splitmix64 state, returning the next pseudo-random 64-bit integer.
+ */
+static uint64_t splitmix64(uint64_t *state) {
+
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+
+}
+
+/**
+ * Returns a pseudo-random number uniformly distributed in `[0, 1)`.
+ */
+static double uniform(uint64_t *state) { return (splitmix64(state) >> 11) * 0x1.0p-53; }
+
+/**
+ * Abscissae and weights of the Gauss-Patterson rules with `2^l - 1` points on `[-1, 1]`, for levels
+ * `l = 1, ..., GP_LEVELS`, each rule extending the previous one. The rule of level `l` is listed at
+ * offset `2^(l - 1) - 1` by its non-negative abscissae, from the outermost to the center.
+ */
+static const double xgp[63] = {
+    0.000000000000000000000000000000000, 0.774596669241483377035853079956480,
+    0.000000000000000000000000000000000, 0.960491268708020283423507092629080,
+    0.774596669241483377035853079956480, 0.434243749346802558002071502844628,
+    0.000000000000000000000000000000000, 0.993831963212755022208512841307951,
+    0.960491268708020283423507092629080, 0.888459232872256998890420167258503,
+    0.774596669241483377035853079956480, 0.621102946737226402940687443816595,
+    0.434243749346802558002071502844628, 0.223386686428966881628203986843998,
+    0.000000000000000000000000000000000, 0.999098124967667597662226062412998,
+    0.993831963212755022208512841307951, 0.981531149553740106867361888547026,
+    0.960491268708020283423507092629080, 0.929654857429740056670125725933374,
+    0.888459232872256998890420167258503, 0.836725938168868735502753818110222,
+    0.774596669241483377035853079956480, 0.702496206491527078609800156008001,
+    0.621102946737226402940687443816595, 0.531319743644375623972103438052469,
+    0.434243749346802558002071502844628, 0.331135393257976833092640782248747,
+    0.223386686428966881628203986843998, 0.112488943133186625745843327560319,
+    0.000000000000000000000000000000000, 0.999872888120357611937956782213944,
+    0.999098124967667597662226062412998, 0.997206259372221959076452532976228,
+    0.993831963212755022208512841307951, 0.988684757547429479938528919613635,
+    0.981531149553740106867361888547026, 0.972182874748581796578058835234688,
+    0.960491268708020283423507092629080, 0.946342858373402905148496208230196,
+    0.929654857429740056670125725933374, 0.910371156957004292497790670606628,
+    0.888459232872256998890420167258503, 0.863907938193690477146415857372834,
+    0.836725938168868735502753818110222, 0.806940531950217611856307980888498,
+    0.774596669241483377035853079956480, 0.739756044352694758677217797247848,
+    0.702496206491527078609800156008001, 0.662909660024780595461015255689389,
+    0.621102946737226402940687443816595, 0.577195710052045814843690955654189,
+    0.531319743644375623972103438052469, 0.483618026945841027562153280531750,
+    0.434243749346802558002071502844628, 0.383359324198730346916485193850313,
+    0.331135393257976833092640782248747, 0.277749822021824315065356412191446,
+    0.223386686428966881628203986843998, 0.168235251552207464982313275440102,
+    0.112488943133186625745843327560319, 0.056344313046592789971967860789447,
+    0.000000000000000000000000000000000
+};
+static const double wgp[63] = {
+    2.000000000000000000000000000000000, 0.555555555555555555555555555555556,
+    0.888888888888888888888888888888889, 0.104656226026467265193823857192073,
+    0.268488089868333440728569280666710, 0.401397414775962222905051818618432,
+    0.450916538658474142345110087045571, 0.017001719629940260339027417402654,
+    0.051603282997079739696920120567861, 0.092927195315124537685894222654169,
+    0.134415255243784220359968764802492, 0.171511909136391380787353165019717,
+    0.200628529376989021033931873331359, 0.219156858401587496403693161643774,
+    0.225510499798206687386422549155950, 0.002544780791561874415402782329831,
+    0.008434565739321106246314929644160, 0.016446049854387810933788388068980,
+    0.025807598096176653564646118765233, 0.035957103307129322096777826220970,
+    0.046462893261757986541404642963942, 0.056979509494123357412197366545720,
+    0.067207754295990703540401063581343, 0.076879620499003531042705190080946,
+    0.085755920049990351154186520436798, 0.093627109981264473616658780339260,
+    0.100314278611795578771293642695006, 0.105669893580234809743815890442169,
+    0.109578421055924638236688360572517, 0.111956873020953456880143562321224,
+    0.112755256720768691607149869983805, 0.000363221481845530659693580600241,
+    0.001265156556230068011372609099982, 0.002579049794685688272427795558562,
+    0.004217630441558854839084226823574, 0.006115506822117246339678283833261,
+    0.008223007957235929669257784415468, 0.010498246909621321898272844583636,
+    0.012903800100351265625976653218633, 0.015406750466559497802130826331548,
+    0.017978551568128270332896046670861, 0.020594233915912711149188561950320,
+    0.023231446639910269443256488936585, 0.025869679327214746910758266244848,
+    0.028489754745833548612506094772398, 0.031073551111687964879884387824542,
+    0.033603877148207730541733988473174, 0.036064432780782572640107160589607,
+    0.038439810249455532038640346777879, 0.040715510116944318933894095600512,
+    0.042877960025007734492912303781982, 0.044914531653632197414254248261831,
+    0.046813554990628012402648082334349, 0.048564330406673198715947118166752,
+    0.050157139305899537413679547423951, 0.051583253952048458776809100857526,
+    0.052834946790116519862076656396531, 0.053905499335266063926876954886363,
+    0.054789210527962865032217530994156, 0.055481404356559363987838407995547,
+    0.055978436510476319407553378587227, 0.056277699831254301272595349425542,
+    0.056377628360384717387662557165235
+};
+
+/**
+ * Writes the abscissae in ascending order and weights of the Clenshaw-Curtis rule with `n` nodes on
+ * `[-1, 1]`, which integrates exactly the interpolating polynomial at the Chebyshev extrema.
+ */
+static void clenshaw_curtis(unsigned int n, double *x, double *w) {
+
+    if (n == 1) {
+        *x = 0., *w = 2.;
+        return;
+    }
+
+    const unsigned int N = n - 1;
+    for (unsigned int j = 0; j <= N; ++j) {
+        double sum = 0.;
+        for (unsigned int k = 1; k <= N / 2; ++k) {
+            sum += (2 * k == N ? 1. : 2.) / (4. * k * k - 1) * cos(2 * M_PI * ((uint64_t)k * j % N) / N);
+        }
+        *(x + j) = -cos(M_PI * j / N);
+        *(w + j) = (j == 0 || j == N ? 1. : 2.) / N * (1 - sum);
+    }
+    if (N % 2 == 0) { *(x + N / 2) = 0.; }
+
+}
+
+/**
+ * Evaluates the Legendre polynomials of degrees `n` and `n - 1` at a point by their recurrence.
+ */
+static void legendre(unsigned int n, double x, double *p, double *q) {
+
+    double p0 = 1., p1 = x;
+    for (unsigned int k = 2; k <= n; ++k) {
+        const double p2 = ((2 * k - 1) * x * p1 - (k - 1) * p0) / k;
+        p0 = p1, p1 = p2;
+    }
+    *p = n ? p1 : 1., *q = n ? p0 : 0.;
+
+}
+
+/**
+ * Writes the abscissae in ascending order and weights of the Gauss-Legendre rule with `n` nodes on
+ * `[-1, 1]`, found as the roots of the Legendre polynomial of degree `n` by Newton's method.
+ */
+static void gauss_legendre(unsigned int n, double *x, double *w) {
+
+    for (unsigned int i = 0; i < (n + 1) / 2; ++i) {
+
+        double t = cos(M_PI * (i + 0.75) / (n + 0.5)), p, q, dp;
+        for (unsigned int iter = 0; iter < 100; ++iter) {
+            legendre(n, t, &p, &q);
+            dp = n * (t * p - q) / (t * t - 1);
+            const double dt = p / dp;
+            t -= dt;
+            if (fabs(dt) <= 4 * DBL_EPSILON) { break; }
+        }
+        legendre(n, t, &p, &q);
+        dp = n * (t * p - q) / (t * t - 1);
+
+        *(x + i) = -t, *(x + n - 1 - i) = t;
+        *(w + i) = *(w + n - 1 - i) = 2 / ((1 - t * t) * dp * dp);
+
+    }
+    if (n % 2) { *(x + n / 2) = 0.; }
+
+}
+
+/**
+ * Writes the abscissae in ascending order and weights of the Gauss-Lobatto rule with `n >= 2` nodes
+ * on `[-1, 1]`, made of both endpoints and the roots of the derivative of the Legendre polynomial of
+ * degree `n - 1`.
+ */
+static void gauss_lobatto(unsigned int n, double *x, double *w) {
+
+    const unsigned int N = n - 1;
+    *x = -1., *(x + N) = 1.;
+    *w = *(w + N) = 2. / (n * N);
+
+    for (unsigned int i = 1; i < (n + 1) / 2; ++i) {
+
+        double t = cos(M_PI * i / N), p, q;
+        for (unsigned int iter = 0; iter < 100; ++iter) {
+            legendre(N, t, &p, &q);
+            const double dp = N * (t * p - q) / (t * t - 1);
+            const double d2p = (2 * t * dp - N * (N + 1.) * p) / (1 - t * t);
+            const double dt = dp / d2p;
+            t -= dt;
+            if (fabs(dt) <= 4 * DBL_EPSILON) { break; }
+        }
+        legendre(N, t, &p, &q);
+
+        *(x + i) = -t, *(x + N - i) = t;
+        *(w + i) = *(w + N - i) = 2 / (n * N * p * p);
+
+    }
+    if (n % 2) { *(x + N / 2) = 0.; }
+
+}
+
+/**
+ * Writes the abscissae in ascending order and weights of the nested rule of a level on `[-1, 1]`.
+ */
+static void nested_nodes(enum QuadratureRules rule, unsigned int level, double *x, double *w) {
+
+    if (rule == GAUSS_PATTERSON) {
+        const unsigned int h = 1u << (level - 1), m = 2 * h - 1;
+        const double *xh = xgp + h - 1, *wh = wgp + h - 1;
+        for (unsigned int j = 0; j < m; ++j) {
+            *(x + j) = j + 1 < h ? -*(xh + j) : *(xh + m - 1 - j);
+            *(w + j) = j + 1 < h ? *(wh + j) : *(wh + m - 1 - j);
+        }
+        return;
+    }
+
+    clenshaw_curtis(level == 1 ? 1 : (1u << (level - 1)) + 1, x, w);
+
+}
+
+/**
+ * Writes the abscissae in ascending order and weights of the Gauss-Patterson rule with `n = 2^l - 1`
+ * nodes on `[-1, 1]`.
+ */
+static void gauss_patterson(unsigned int n, double *x, double *w) {
+
+    unsigned int level = 1;
+    while ((2u << (level - 1)) - 1 < n) { ++level; }
+    nested_nodes(GAUSS_PATTERSON, level, x, w);
+
+}
+
+/**
+ * Writes the abscissae in ascending order and weights of a Gauss or Clenshaw-Curtis rule with `n`
+ * nodes on `[-1, 1]`, through the persistent rule cache.
+ */
+static void rule_nodes(enum QuadratureRules rule, unsigned int n, double *x, double *w) {
+
+    switch (rule) {
+        case GAUSS_LEGENDRE:
+            load_rule(rule, n, NULL, gauss_legendre, x, w);
+            break;
+        case GAUSS_LOBATTO:
+            load_rule(rule, n, NULL, gauss_lobatto, x, w);
+            break;
+        case CLENSHAW_CURTIS:
+            load_rule(rule, n, NULL, clenshaw_curtis, x, w);
+            break;
+        default:
+            gauss_patterson(n, x, w);
+            break;
+    }
+
+}
+
+/**
+ * Returns the number of domain elements of a rule along an interval, or `0` if the rule does not
+ * support the number of subintervals of the interval. Riemann rules, the trapezoidal rule and
+ * Simpson's rule take `n` subintervals, and the other rules take `n` nodes.
+ */
+static unsigned int rule_size(enum QuadratureRules rule, unsigned int n) {
+
+    switch (rule) {
+        case TRAPEZOID:
+            return n < UINT_MAX ? n + 1 : 0;
+        case SIMPSON:
+            return n % 2 == 0 && n < UINT_MAX ? n + 1 : 0;
+        case GAUSS_LOBATTO:
+            return n >= 2 ? n : 0;
+        case GAUSS_PATTERSON:
+            return n < (2u << (GP_LEVELS - 1)) && !((n + 1) & n) ? n : 0;
+        default:
+            return n;
+    }
+
+}
+
+/**
+ * Builds a tensor-product grid with the domain elements and weights along each interval given by its
+ * own rule, among the Riemann rules and the rules of `enum QuadratureRules`.
+ *
+ * @param intervals The intervals spanning the grid
+ * @param rules The rule along each interval
+ * @param d The number of intervals
+ * @return A dynamically allocated grid, or `NULL` upon failure
+ */
+struct Grid *tensor_grid(struct Interval **intervals, enum QuadratureRules *rules, unsigned int d) {
+
+    if (bounded(intervals, d) == -1) { return NULL; }
+
+    struct Grid *grid = (struct Grid *)malloc(sizeof(struct Grid));
+    if (!grid) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    grid->d = d;
+    grid->sizes = (unsigned int *)calloc(d, sizeof(unsigned int));
+    grid->nodes = (double **)calloc(d, sizeof(double *));
+    grid->weights = (double **)calloc(d, sizeof(double *));
+    if (!grid->sizes || !grid->nodes || !grid->weights) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free_grid(grid);
+        return NULL;
+    }
+
+    grid->npoints = 1;
+    for (unsigned int i = 0; i < d; ++i) {
+
+        struct Interval *interval = *(intervals + i);
+        const enum QuadratureRules rule = *(rules + i);
+        if ((int)rule < LEFT || rule > TRAPEZOID) {
+            PyErr_SetString(PyExc_ValueError, "Invalid quadrature rule");
+            free_grid(grid);
+            return NULL;
+        }
+
+        const unsigned int size = interval->n ? rule_size(rule, interval->n) : 0;
+        if (size == 0) {
+            PyErr_SetString(PyExc_ValueError, "Invalid number of subintervals or nodes for quadrature rule");
+            free_grid(grid);
+            return NULL;
+        }
+        if (grid->npoints > UINT64_MAX / size) {
+            PyErr_SetString(PyExc_OverflowError, "Too many domain elements in grid");
+            free_grid(grid);
+            return NULL;
+        }
+        *(grid->sizes + i) = size;
+        grid->npoints *= size;
+
+        double *nodes = *(grid->nodes + i) = (double *)calloc(size, sizeof(double));
+        double *weights = *(grid->weights + i) = (double *)calloc(size, sizeof(double));
+        if (!nodes || !weights) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            free_grid(grid);
+            return NULL;
+        }
+
+        const double dx = (interval->upper - interval->lower) / interval->n;
+        const double mid = (interval->lower + interval->upper) / 2;
+        const double half = (interval->upper - interval->lower) / 2;
+        switch (rule) {
+            case GAUSS_LEGENDRE:
+            case GAUSS_LOBATTO:
+            case CLENSHAW_CURTIS:
+            case GAUSS_PATTERSON:
+                rule_nodes(rule, size, nodes, weights);
+                break;
+            default:
+                for (unsigned int j = 0; j < size; ++j) {
+                    switch ((int)rule) {
+                        case LEFT:
+                            left(interval, j, nodes + j);
+                            break;
+                        case RIGHT:
+                            right(interval, j, nodes + j);
+                            break;
+                        case MIDPOINT:
+                            midpoint(interval, j, nodes + j);
+                            break;
+                        default:
+                            endpoint(interval, j, nodes + j);
+                            break;
+                    }
+                    *(weights + j) = rule == SIMPSON ? (j % 2 ? 4 : 2) * dx / 3 : dx;
+                }
+                if (rule == TRAPEZOID) { *weights /= 2, *(weights + size - 1) /= 2; }
+                if (rule == SIMPSON) { *weights = *(weights + size - 1) = dx / 3; }
+                continue;
+        }
+
+        for (unsigned int j = 0; j < size; ++j) {
+            *(nodes + j) = mid + *(nodes + j) * half;
+            *(weights + j) *= half;
+        }
+
+    }
+
+    return grid;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables over a tensor-product grid with a
+ * rule per interval.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param rules The rule along each interval
+ * @param d The number of dimensions in the domain of `f`
+ * @param nthreads The number of threads to use if `f` is native
+ * @param res The location to which to write the integral estimate
+ * @return `0` upon success, or `-1` upon failure
+ */
+short tensor(
+    struct Function *f, struct Interval **intervals, enum QuadratureRules *rules, unsigned int d,
+    unsigned int nthreads, double *res
+) {
+
+    struct Grid *grid = tensor_grid(intervals, rules, d);
+    if (!grid) { return -1; }
+
+    short err = tensor_sum(f, grid, nthreads, res);
+    free_grid(grid);
+
+    return err;
+
+}
+
+/**
+ * Returns the index of a node of a nested rule in the rule of the previous level, or `-1` if the node
+ * is new at its level.
+ */
+static long nested_parent(enum QuadratureRules rule, unsigned int level, unsigned int j) {
+
+    if (level == 1) { return -1; }
+    if (rule == GAUSS_PATTERSON) { return j % 2 ? (long)(j - 1) / 2 : -1; }
+    if (level == 2) { return j == 1 ? 0 : -1; }
+
+    return j % 2 ? -1 : (long)j / 2;
+
+}
+
+void free_nested_rule(struct NestedRule *nr) {
+
+    if (!nr) { return; }
+    for (unsigned int l = 0; l < nr->levels; ++l) {
+        if (nr->nodes) { free(*(nr->nodes + l)); }
+        if (nr->weights) { free(*(nr->weights + l)); }
+        if (nr->ids) { free(*(nr->ids + l)); }
+    }
+    free(nr->sizes); free(nr->nodes); free(nr->weights); free(nr->ids);
+    free(nr);
+
+}
+
+/**
+ * Tabulates the levels of a nested rule on `[-1, 1]`. Each level holds the weights of the difference
+ * between its rule and the rule of the previous level, and a unique identifier for each node that is
+ * shared by all the levels containing it.
+ *
+ * @param rule The family of nested rules
+ * @param levels The number of levels
+ * @return A dynamically allocated nested rule, or `NULL` upon failure
+ */
+struct NestedRule *nested_rule(enum QuadratureRules rule, unsigned int levels) {
+
+    struct NestedRule *nr = (struct NestedRule *)calloc(1, sizeof(struct NestedRule));
+    if (!nr) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    nr->levels = levels;
+    nr->sizes = (unsigned int *)calloc(levels, sizeof(unsigned int));
+    nr->nodes = (double **)calloc(levels, sizeof(double *));
+    nr->weights = (double **)calloc(levels, sizeof(double *));
+    nr->ids = (uint32_t **)calloc(levels, sizeof(uint32_t *));
+    if (!nr->sizes || !nr->nodes || !nr->weights || !nr->ids) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free_nested_rule(nr);
+        return NULL;
+    }
+
+    double *previous = NULL;
+    uint32_t next = 0;
+    for (unsigned int l = 0; l < levels; ++l) {
+
+        const unsigned int m = rule == GAUSS_PATTERSON ? (2u << l) - 1 : (l ? (1u << l) + 1 : 1);
+        *(nr->sizes + l) = m;
+        double *x = *(nr->nodes + l) = (double *)calloc(m, sizeof(double));
+        double *dw = *(nr->weights + l) = (double *)calloc(m, sizeof(double));
+        uint32_t *ids = *(nr->ids + l) = (uint32_t *)calloc(m, sizeof(uint32_t));
+        double *w = (double *)calloc(m, sizeof(double));
+        if (!x || !dw || !ids || !w) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            free(previous); free(w);
+            free_nested_rule(nr);
+            return NULL;
+        }
+
+        nested_nodes(rule, l + 1, x, w);
+        for (unsigned int j = 0; j < m; ++j) {
+            const long parent = nested_parent(rule, l + 1, j);
+            *(ids + j) = parent < 0 ? next++ : *(*(nr->ids + l - 1) + parent);
+            *(dw + j) = parent < 0 ? *(w + j) : *(w + j) - *(previous + parent);
+        }
+
+        free(previous);
+        previous = w;
+
+    }
+    free(previous);
+
+    return nr;
+
+}
+
+/**
+ * An open-addressing hash table mapping keys of `d` 32-bit integers to values.
+ */
+struct Table {
+    unsigned int d;
+    size_t capacity;
+    size_t size;
+    uint32_t *keys;
+    double *values;
+    unsigned char *used;
+};
+
+static struct Table *new_table(unsigned int d, size_t capacity) {
+
+    struct Table *t = (struct Table *)malloc(sizeof(struct Table));
+    if (!t) { return NULL; }
+
+    t->d = d, t->capacity = capacity, t->size = 0;
+    t->keys = (uint32_t *)malloc(capacity * d * sizeof(uint32_t));
+    t->values = (double *)malloc(capacity * sizeof(double));
+    t->used = (unsigned char *)calloc(capacity, sizeof(unsigned char));
+    if (!t->keys || !t->values || !t->used) {
+        free(t->keys); free(t->values); free(t->used);
+        free(t);
+        return NULL;
+    }
+
+    return t;
+
+}
+
+static void free_table(struct Table *t) {
+
+    if (!t) { return; }
+    free(t->keys); free(t->values); free(t->used);
+    free(t);
+
+}
+
+/**
+ * Returns the slot of a key in a hash table, which is either the slot holding the key or the empty
+ * slot at which to insert it.
+ */
+static size_t table_slot(const struct Table *t, const uint32_t *key) {
+
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (unsigned int j = 0; j < t->d; ++j) { h = (h ^ *(key + j)) * 0x100000001B3ULL; }
+    size_t slot = (size_t)(splitmix64(&h) & (t->capacity - 1));
+
+    while (*(t->used + slot) && memcmp(t->keys + slot * t->d, key, t->d * sizeof(uint32_t))) {
+        slot = (slot + 1) & (t->capacity - 1);
+    }
+
+    return slot;
+
+}
+
+/**
+ * Returns the value of a key in a hash table, or `NULL` if the key is absent.
+ */
+static double *table_find(const struct Table *t, const uint32_t *key) {
+
+    const size_t slot = table_slot(t, key);
+
+    return *(t->used + slot) ? t->values + slot : NULL;
+
+}
+
+/**
+ * Sets the value of a key in a hash table, doubling its capacity whenever it is half full.
+ *
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short table_insert(struct Table *t, const uint32_t *key, double value) {
+
+    if (2 * (t->size + 1) > t->capacity) {
+        struct Table *grown = new_table(t->d, 2 * t->capacity);
+        if (!grown) { return -1; }
+        for (size_t slot = 0; slot < t->capacity; ++slot) {
+            if (!*(t->used + slot)) { continue; }
+            const size_t s = table_slot(grown, t->keys + slot * t->d);
+            memcpy(grown->keys + s * t->d, t->keys + slot * t->d, t->d * sizeof(uint32_t));
+            *(grown->values + s) = *(t->values + slot), *(grown->used + s) = 1;
+        }
+        grown->size = t->size;
+        free(t->keys); free(t->values); free(t->used);
+        *t = *grown;
+        free(grown);
+    }
+
+    const size_t slot = table_slot(t, key);
+    if (!*(t->used + slot)) {
+        memcpy(t->keys + slot * t->d, key, t->d * sizeof(uint32_t));
+        *(t->used + slot) = 1, ++t->size;
+    }
+    *(t->values + slot) = value;
+
+    return 0;
+
+}
+
+/**
+ * The state of a dimension-adaptive sparse-grid integration. Function values are cached by the
+ * identifiers of the nodes of a domain element along each axis, so that each domain element is
+ * evaluated once however many difference rules contain it.
+ */
+struct Sparse {
+    struct Function *f;
+    struct Interval **intervals;
+    unsigned int d;
+    struct NestedRule *nr;
+    struct Table *cache;
+    double *block;
+    uint32_t *pending;
+    double *values;
+    unsigned int *index;
+    uint32_t *key;
+    uint64_t neval;
+};
+
+/**
+ * Evaluates the pending domain elements of a sparse-grid integration and caches their values.
+ */
+static short flush_pending(struct Sparse *sp, Py_ssize_t count) {
+
+    if (count && eval_block(sp->f, sp->block, count, sp->d, sp->values) == -1) { return -1; }
+    for (Py_ssize_t k = 0; k < count; ++k) {
+        if (table_insert(sp->cache, sp->pending + k * sp->d, *(sp->values + k)) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            return -1;
+        }
+    }
+    sp->neval += count;
+
+    return 0;
+
+}
+
+/**
+ * Applies the tensor product of the difference rules of a multi-index of levels to the integrand,
+ * evaluating it only at the domain elements missing from the cache.
+ *
+ * @param sp The state of the integration
+ * @param levels The level of the difference rule along each axis, starting from `1`
+ * @param delta The location to which to write the result
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short apply_difference(struct Sparse *sp, const uint32_t *levels, double *delta) {
+
+    const unsigned int d = sp->d;
+    const Py_ssize_t N = sp->f->blocksize;
+    struct NestedRule *nr = sp->nr;
+
+    for (short pass = 0; pass < 2; ++pass) {
+
+        struct Reducer r;
+        reducer_init(&r);
+        memset(sp->index, 0, d * sizeof(unsigned int));
+
+        Py_ssize_t k = 0;
+        for (short done = 0; !done;) {
+
+            double w = 1.;
+            for (unsigned int j = 0; j < d; ++j) {
+                const unsigned int l = *(levels + j) - 1, i = *(sp->index + j);
+                *(sp->key + j) = *(*(nr->ids + l) + i);
+                w *= *(*(nr->weights + l) + i);
+            }
+
+            double *value = table_find(sp->cache, sp->key);
+            if (pass) {
+                for (unsigned int j = 0; j < d; ++j) {
+                    struct Interval *interval = *(sp->intervals + j);
+                    w *= (interval->upper - interval->lower) / 2;
+                }
+                reducer_add(&r, w * *value);
+            } else if (!value) {
+                for (unsigned int j = 0; j < d; ++j) {
+                    struct Interval *interval = *(sp->intervals + j);
+                    const double t = *(*(nr->nodes + *(levels + j) - 1) + *(sp->index + j));
+                    *(sp->block + k * d + j) = (
+                        (interval->lower + interval->upper) / 2 + t * (interval->upper - interval->lower) / 2
+                    );
+                }
+                memcpy(sp->pending + k * d, sp->key, d * sizeof(uint32_t));
+                if (++k == N) {
+                    if (flush_pending(sp, k) == -1) { return -1; }
+                    k = 0;
+                }
+            }
+
+            int j = d - 1;
+            for (; j >= 0; --j) {
+                if (++*(sp->index + j) < *(nr->sizes + *(levels + j) - 1)) { break; }
+                *(sp->index + j) = 0;
+            }
+            done = j < 0;
+
+        }
+
+        if (pass) {
+            *delta = reducer_result(&r);
+        } else if (flush_pending(sp, k) == -1) {
+            return -1;
+        }
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables on a dimension-adaptive sparse grid,
+ * following Gerstner and Griebel.
+ *
+ * The integral is the sum of tensor products of difference rules between consecutive levels of a
+ * nested rule, over a downward-closed set of multi-indices of levels. Starting from the lowest
+ * multi-index, the active multi-index with the largest contribution is repeatedly refined along each
+ * axis whose forward neighbor has all its backward neighbors already refined. The sum of the absolute
+ * contributions of the active multi-indices estimates the error, and is only trusted once the lowest
+ * multi-index has been refined. If every multi-index up to `maxlevel` is refined, the error is that of
+ * the last active multi-indices.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param epsabs The absolute error tolerance
+ * @param epsrel The relative error tolerance
+ * @param rule The family of nested rules
+ * @param maxlevel The maximum level along each axis
+ * @param maxeval The maximum number of evaluations of `f`
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @param neval The location to which to write the number of evaluations of `f`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short sparse(
+    struct Function *f, struct Interval **intervals, unsigned int d, double epsabs, double epsrel,
+    enum QuadratureRules rule, unsigned int maxlevel, uint64_t maxeval, double *res, double *err,
+    uint64_t *neval
+) {
+
+    const unsigned int limit = rule == GAUSS_PATTERSON ? GP_LEVELS : CC_LEVELS;
+    if (rule != CLENSHAW_CURTIS && rule != GAUSS_PATTERSON) {
+        PyErr_SetString(PyExc_ValueError, "Expected a nested rule, CLENSHAW_CURTIS or GAUSS_PATTERSON");
+        return -1;
+    }
+    if (d == 0 || maxlevel < 1 || maxlevel > limit) {
+        PyErr_Format(
+            PyExc_ValueError, "Expected at least one interval and a maximum level between 1 and %u", limit
+        );
+        return -1;
+    }
+    if (bounded(intervals, d) == -1) { return -1; }
+
+    struct Sparse sp = {
+        .f = f, .intervals = intervals, .d = d, .nr = nested_rule(rule, maxlevel),
+        .cache = new_table(d, 1024), .neval = 0,
+        .block = (double *)malloc(f->blocksize * d * sizeof(double)),
+        .pending = (uint32_t *)malloc(f->blocksize * d * sizeof(uint32_t)),
+        .values = (double *)malloc(f->blocksize * sizeof(double)),
+        .index = (unsigned int *)malloc(d * sizeof(unsigned int)),
+        .key = (uint32_t *)malloc(d * sizeof(uint32_t))
+    };
+    struct Table *old = new_table(d, 64);
+    size_t nactive = 0, capacity = 64;
+    uint32_t *active = (uint32_t *)malloc(capacity * d * sizeof(uint32_t));
+    double *deltas = (double *)malloc(capacity * sizeof(double));
+    uint32_t *forward = (uint32_t *)malloc(2 * d * sizeof(uint32_t));
+    if (!sp.nr || !sp.cache || !sp.block || !sp.pending || !sp.values || !sp.index || !sp.key
+        || !old || !active || !deltas || !forward) {
+        if (!PyErr_Occurred()) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        free_nested_rule(sp.nr); free_table(sp.cache); free_table(old);
+        free(sp.block); free(sp.pending); free(sp.values); free(sp.index); free(sp.key);
+        free(active); free(deltas); free(forward);
+        return -1;
+    }
+
+    short status = 0;
+    for (unsigned int j = 0; j < d; ++j) { *(active + j) = 1; }
+    status = apply_difference(&sp, active, deltas);
+    nactive = 1;
+    *res = *deltas;
+
+    while (!status && nactive) {
+
+        size_t best = 0;
+        *err = 0.;
+        for (size_t a = 0; a < nactive; ++a) {
+            *err += fabs(*(deltas + a));
+            if (fabs(*(deltas + a)) > fabs(*(deltas + best))) { best = a; }
+        }
+        if (old->size && *err <= (epsabs > epsrel * fabs(*res) ? epsabs : epsrel * fabs(*res))) { break; }
+        if (sp.neval >= maxeval) { break; }
+
+        uint32_t *k = forward + d;
+        memcpy(k, active + best * d, d * sizeof(uint32_t));
+        if (table_insert(old, k, *(deltas + best)) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+            status = -1;
+            break;
+        }
+        --nactive;
+        memmove(active + best * d, active + nactive * d, d * sizeof(uint32_t));
+        *(deltas + best) = *(deltas + nactive);
+
+        for (unsigned int j = 0; j < d && !status; ++j) {
+
+            if (*(k + j) >= maxlevel) { continue; }
+            memcpy(forward, k, d * sizeof(uint32_t));
+            ++*(forward + j);
+
+            short admissible = 1;
+            for (unsigned int i = 0; i < d && admissible; ++i) {
+                if (i == j || *(forward + i) == 1) { continue; }
+                --*(forward + i);
+                admissible = table_find(old, forward) != NULL;
+                ++*(forward + i);
+            }
+            if (!admissible) { continue; }
+
+            if (nactive == capacity) {
+                capacity *= 2;
+                uint32_t *a = (uint32_t *)realloc(active, capacity * d * sizeof(uint32_t));
+                if (a) { active = a; }
+                double *v = (double *)realloc(deltas, capacity * sizeof(double));
+                if (v) { deltas = v; }
+                if (!a || !v) {
+                    PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+                    status = -1;
+                    break;
+                }
+            }
+
+            memcpy(active + nactive * d, forward, d * sizeof(uint32_t));
+            status = apply_difference(&sp, forward, deltas + nactive);
+            if (!status) { *res += *(deltas + nactive++); }
+
+        }
+
+    }
+    *neval = sp.neval;
+
+    free_nested_rule(sp.nr); free_table(sp.cache); free_table(old);
+    free(sp.block); free(sp.pending); free(sp.values); free(sp.index); free(sp.key);
+    free(active); free(deltas); free(forward);
+
+    return status;
+
+}
+
+/**
+ * Degrees, coefficients and initial direction numbers of the primitive polynomials defining the Sobol
+ * sequence in dimensions `2` to `SOBOL_DIMENSIONS`, from the `new-joe-kuo-6.21201` table of Joe and
+ * Kuo. The first dimension is the van der Corput sequence in base 2.
+ */
+static const struct { unsigned int s; unsigned int a; unsigned int m[7]; } sobol_table[SOBOL_DIMENSIONS - 1] = {
+    { 1, 0, { 1 } },
+    { 2, 1, { 1, 3 } },
+    { 3, 1, { 1, 3, 1 } },
+    { 3, 2, { 1, 1, 1 } },
+    { 4, 1, { 1, 1, 3, 3 } },
+    { 4, 4, { 1, 3, 5, 13 } },
+    { 5, 2, { 1, 1, 5, 5, 17 } },
+    { 5, 4, { 1, 1, 5, 5, 5 } },
+    { 5, 7, { 1, 1, 7, 11, 19 } },
+    { 5, 11, { 1, 1, 5, 1, 1 } },
+    { 5, 13, { 1, 1, 1, 3, 11 } },
+    { 5, 14, { 1, 3, 5, 5, 31 } },
+    { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+    { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+    { 6, 16, { 1, 3, 1, 13, 27, 49 } },
+    { 6, 19, { 1, 1, 1, 15, 7, 5 } },
+    { 6, 22, { 1, 3, 1, 15, 13, 25 } },
+    { 6, 25, { 1, 1, 5, 5, 19, 61 } },
+    { 7, 1, { 1, 3, 7, 11, 23, 15, 103 } },
+    { 7, 4, { 1, 3, 7, 13, 13, 15, 69 } },
+    { 7, 7, { 1, 1, 3, 13, 7, 35, 63 } },
+    { 7, 8, { 1, 3, 5, 9, 1, 25, 53 } },
+    { 7, 14, { 1, 3, 1, 13, 9, 35, 107 } },
+    { 7, 19, { 1, 3, 1, 5, 27, 61, 31 } },
+    { 7, 21, { 1, 1, 5, 11, 19, 41, 61 } },
+    { 7, 28, { 1, 3, 5, 3, 3, 13, 69 } },
+    { 7, 31, { 1, 1, 7, 13, 1, 19, 1 } },
+    { 7, 32, { 1, 3, 7, 5, 13, 19, 59 } },
+    { 7, 37, { 1, 1, 3, 9, 25, 29, 41 } },
+    { 7, 41, { 1, 3, 5, 13, 23, 1, 55 } },
+    { 7, 42, { 1, 3, 7, 3, 13, 59, 17 } },
+};
+
+/**
+ * The state of a low-discrepancy point set in the unit cube, generated point by point.
+ */
+struct Sequence {
+    enum QMCRules rule;
+    unsigned int d;
+    uint64_t n;
+    uint64_t index;
+    uint32_t *directions;
+    uint32_t *state;
+    unsigned int *bases;
+    uint64_t *generator;
+};
+
+/**
+ * Computes the 32-bit direction numbers of the first `d` dimensions of the Sobol sequence.
+ */
+static void sobol_directions(uint32_t *v, unsigned int d) {
+
+    for (unsigned int i = 0; i < 32; ++i) { *(v + i) = (uint32_t)1 << (31 - i); }
+
+    for (unsigned int j = 1; j < d; ++j) {
+
+        uint32_t *vj = v + 32 * j;
+        const unsigned int s = sobol_table[j - 1].s, a = sobol_table[j - 1].a;
+
+        for (unsigned int i = 0; i < s; ++i) { *(vj + i) = sobol_table[j - 1].m[i] << (31 - i); }
+        for (unsigned int i = s; i < 32; ++i) {
+            *(vj + i) = *(vj + i - s) ^ (*(vj + i - s) >> s);
+            for (unsigned int k = 1; k < s; ++k) {
+                if ((a >> (s - 1 - k)) & 1) { *(vj + i) ^= *(vj + i - k); }
+            }
+        }
+
+    }
+
+}
+
+/**
+ * Writes the first `d` prime numbers.
+ */
+static void primes(unsigned int *p, unsigned int d) {
+
+    unsigned int count = 0;
+    for (unsigned int candidate = 2; count < d; ++candidate) {
+        short prime = 1;
+        for (unsigned int k = 0; k < count && *(p + k) * *(p + k) <= candidate; ++k) {
+            if (candidate % *(p + k) == 0) {
+                prime = 0;
+                break;
+            }
+        }
+        if (prime) { *(p + count++) = candidate; }
+    }
+
+}
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+
+    while (b) {
+        uint64_t t = a % b;
+        a = b, b = t;
+    }
+
+    return a;
+
+}
+
+/**
+ * Constructs the generating vector of a rank-1 lattice with `n` points component by component,
+ * minimizing the worst-case error in the weighted Korobov space of smoothness 2 with product weights
+ * `1 / j^2`. At most `CBC_CANDIDATES` candidates, drawn deterministically, are tried per component.
+ *
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short lattice_generator(uint64_t *z, unsigned int d, uint64_t n) {
+
+    double *omega = (double *)calloc(n, sizeof(double));
+    double *p = (double *)calloc(n, sizeof(double));
+    if (!omega || !p) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(omega); free(p);
+        return -1;
+    }
+
+    for (uint64_t k = 0; k < n; ++k) {
+        const double x = (double)k / n;
+        *(omega + k) = 2 * M_PI * M_PI * (x * x - x + 1. / 6);
+        *(p + k) = 1.;
+    }
+
+    uint64_t seed = 0;
+    for (unsigned int j = 0; j < d; ++j) {
+
+        const double gamma = 1. / ((j + 1.) * (j + 1.));
+        const uint64_t half = n / 2;
+        const short exhaustive = half <= CBC_CANDIDATES;
+
+        double best = INFINITY;
+        *(z + j) = 1;
+        for (uint64_t c = 0; j > 0 && c < (exhaustive ? half : CBC_CANDIDATES); ++c) {
+
+            const uint64_t candidate = exhaustive ? c + 1 : 1 + splitmix64(&seed) % half;
+            if (gcd(candidate, n) != 1) { continue; }
+
+            double e = 0.;
+            for (uint64_t k = 0; k < n; ++k) { e += *(p + k) * (1 + gamma * *(omega + k * candidate % n)); }
+            if (e < best) { best = e, *(z + j) = candidate; }
+
+        }
+
+        for (uint64_t k = 0; k < n; ++k) { *(p + k) *= 1 + gamma * *(omega + k * *(z + j) % n); }
+
+    }
+
+    free(omega); free(p);
+
+    return 0;
+
+}
+
+static void free_sequence(struct Sequence *seq) {
+
+    if (!seq) { return; }
+    free(seq->directions); free(seq->state); free(seq->bases); free(seq->generator);
+    free(seq);
+
+}
+
+/**
+ * Prepares a low-discrepancy point set of `n` points in the unit cube of dimension `d`.
+ */
+static struct Sequence *new_sequence(enum QMCRules rule, unsigned int d, uint64_t n) {
+
+    struct Sequence *seq = (struct Sequence *)calloc(1, sizeof(struct Sequence));
+    if (!seq) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return NULL;
+    }
+    seq->rule = rule, seq->d = d, seq->n = n;
+
+    switch (rule) {
+        case SOBOL:
+            if (d > SOBOL_DIMENSIONS || n > ((uint64_t)1 << 32)) {
+                PyErr_Format(
+                    PyExc_ValueError, "Sobol points are available for up to %d dimensions and 2^32 points",
+                    SOBOL_DIMENSIONS
+                );
+                free_sequence(seq);
+                return NULL;
+            }
+            seq->directions = (uint32_t *)calloc(32 * d, sizeof(uint32_t));
+            seq->state = (uint32_t *)calloc(d, sizeof(uint32_t));
+            if (!seq->directions || !seq->state) { break; }
+            sobol_directions(seq->directions, d);
+            return seq;
+        case HALTON:
+            if (!(seq->bases = (unsigned int *)calloc(d, sizeof(unsigned int)))) { break; }
+            primes(seq->bases, d);
+            return seq;
+        case LATTICE:
+            if (!(seq->generator = (uint64_t *)calloc(d, sizeof(uint64_t)))) { break; }
+            if (lattice_generator(seq->generator, d, n) == -1) {
+                free_sequence(seq);
+                return NULL;
+            }
+            return seq;
+        default:
+            PyErr_SetString(PyExc_ValueError, "Invalid quasi-Monte Carlo rule");
+            free_sequence(seq);
+            return NULL;
+    }
+
+    PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+    free_sequence(seq);
+
+    return NULL;
+
+}
+
+/**
+ * Writes the next point of a randomized point set, scaled to the domain of integration. Sobol points
+ * are randomized by a digital shift, and Halton and lattice points by a shift modulo 1.
+ *
+ * @param seq The point set
+ * @param shift The random shift of the current randomization, one per dimension
+ * @param intervals The intervals spanning the domain of integration
+ * @param x The location to which to write the point
+ */
+static void next_point(struct Sequence *seq, const double *shift, struct Interval **intervals, double *x) {
+
+    const uint64_t i = seq->index++;
+
+    for (unsigned int j = 0; j < seq->d; ++j) {
+
+        double u;
+        switch (seq->rule) {
+            case SOBOL:
+                if (i == 0) {
+                    *(seq->state + j) = 0;
+                } else {
+                    unsigned int c = 0;
+                    for (uint64_t k = i - 1; k & 1; k >>= 1) { ++c; }
+                    *(seq->state + j) ^= *(seq->directions + 32 * j + c);
+                }
+                u = (*(seq->state + j) ^ (uint32_t)(*(shift + j) * 0x1.0p32)) * 0x1.0p-32;
+                break;
+            case HALTON: {
+                const unsigned int b = *(seq->bases + j);
+                double f = 1., r = 0.;
+                for (uint64_t k = i; k > 0; k /= b) {
+                    f /= b;
+                    r += f * (k % b);
+                }
+                u = r + *(shift + j);
+                break;
+            }
+            default:
+                u = (double)(i * *(seq->generator + j) % seq->n) / seq->n + *(shift + j);
+                break;
+        }
+        if (u >= 1.) { u -= 1.; }
+
+        struct Interval *interval = *(intervals + j);
+        *(x + j) = interval->lower + u * (interval->upper - interval->lower);
+
+    }
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables by randomized quasi-Monte Carlo.
+ *
+ * The point set is randomized `nshifts` times with independent random shifts. Each randomization
+ * gives an unbiased estimate of the integral; the result is their mean, and the error estimate is
+ * their standard error. Points are generated and evaluated in blocks of `f->blocksize` points.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param rule The low-discrepancy point set to use
+ * @param n The number of points per randomization
+ * @param nshifts The number of randomizations
+ * @param seed The seed of the random shifts
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @return `0` upon success, or `-1` upon failure
+ */
+short qmc(
+    struct Function *f, struct Interval **intervals, unsigned int d, enum QMCRules rule, uint64_t n,
+    unsigned int nshifts, uint64_t seed, double *res, double *err
+) {
+
+    if (d == 0 || n == 0 || nshifts == 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected at least one interval, point and randomization");
+        return -1;
+    }
+    if (bounded(intervals, d) == -1) { return -1; }
+
+    struct Sequence *seq = new_sequence(rule, d, n);
+    if (!seq) { return -1; }
+
+    const Py_ssize_t N = f->blocksize;
+    double *block = (double *)calloc(N * d, sizeof(double));
+    double *values = (double *)calloc(N, sizeof(double));
+    double *shift = (double *)calloc(d, sizeof(double));
+    double *estimates = (double *)calloc(nshifts, sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc(sizeof(struct Reducer));
+    if (!block || !values || !shift || !estimates || !r) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(values); free(shift); free(estimates); free(r); free_sequence(seq);
+        return -1;
+    }
+
+    double volume = 1.;
+    for (unsigned int j = 0; j < d; ++j) { volume *= (*(intervals + j))->upper - (*(intervals + j))->lower; }
+
+    uint64_t state = seed;
+    for (unsigned int s = 0; s < nshifts; ++s) {
+
+        for (unsigned int j = 0; j < d; ++j) { *(shift + j) = uniform(&state); }
+        seq->index = 0;
+        reducer_init(r);
+
+        for (uint64_t i = 0; i < n; i += N) {
+            const Py_ssize_t count = n - i < (uint64_t)N ? (Py_ssize_t)(n - i) : N;
+            for (Py_ssize_t k = 0; k < count; ++k) { next_point(seq, shift, intervals, block + k * d); }
+            if (eval_block(f, block, count, d, values) == -1) {
+                free(block); free(values); free(shift); free(estimates); free(r); free_sequence(seq);
+                return -1;
+            }
+            for (Py_ssize_t k = 0; k < count; ++k) { reducer_add(r, *(values + k)); }
+        }
+
+        *(estimates + s) = volume * reducer_result(r) / n;
+
+    }
+
+    double mean = 0., var = 0.;
+    for (unsigned int s = 0; s < nshifts; ++s) { mean += *(estimates + s); }
+    mean /= nshifts;
+    for (unsigned int s = 0; s < nshifts; ++s) {
+        var += (*(estimates + s) - mean) * (*(estimates + s) - mean);
+    }
+    *res = mean;
+    *err = nshifts > 1 ? sqrt(var / (nshifts - 1) / nshifts) : INFINITY;
+
+    free(block); free(values); free(shift); free(estimates); free(r); free_sequence(seq);
+
+    return 0;
+
+}
+
+/**
+ * The shared state of a VEGAS iteration. Samples are stratified over `ncubes` hypercubes of equal
+ * volume in the unit cube, with `npc` samples per hypercube, and mapped to the domain of integration
+ * through the piecewise-linear map of each axis. Chunks either span `cubes` whole hypercubes or, if
+ * hypercubes hold more samples than a chunk, one of `pieces` consecutive parts of a single hypercube.
+ * Each chunk draws from its own random generator, seeded by the seed, the iteration and the chunk, and
+ * its results are combined in order, so that the result does not depend on the number of threads.
+ */
+struct VegasTask {
+    struct Function *f;
+    struct Interval **intervals;
+    unsigned int d;
+    const double *edges;
+    double volume;
+    uint64_t nstrat;
+    uint64_t ncubes;
+    uint64_t npc;
+    uint64_t pieces;
+    uint64_t cubes;
+    uint64_t seed;
+    unsigned int iteration;
+    double *sums;
+    double *bins;
+    short native;
+    short failed;
+};
+
+/**
+ * Samples the integrand over one chunk, writing either the estimate and variance of the whole
+ * hypercubes in the chunk, or the sums of the values and squared values over a part of a hypercube,
+ * and accumulating the squared values into the bins of each axis. The seed, the iteration and the
+ * chunk are mixed in turn through splitmix64, so that distinct triples draw independent streams.
+ *
+ * @return `0` upon success, or `-1` upon failure
+ */
+static short vegas_chunk(struct VegasTask *task, size_t chunk) {
+
+    const unsigned int d = task->d;
+    uint64_t c0, c1, n;
+    if (task->pieces > 1) {
+        const uint64_t p = chunk % task->pieces;
+        c0 = chunk / task->pieces, c1 = c0 + 1;
+        n = task->npc * (p + 1) / task->pieces - task->npc * p / task->pieces;
+    } else {
+        c0 = chunk * task->cubes;
+        c1 = c0 + task->cubes < task->ncubes ? c0 + task->cubes : task->ncubes;
+        n = task->npc;
+    }
+    const uint64_t total = (c1 - c0) * n;
+
+    double *block = (double *)malloc(total * d * sizeof(double));
+    double *jacobians = (double *)malloc(total * sizeof(double));
+    double *values = (double *)malloc(total * sizeof(double));
+    unsigned int *indices = (unsigned int *)malloc(total * d * sizeof(unsigned int));
+    if (!block || !jacobians || !values || !indices) {
+        task->failed = 1;
+        free(block); free(jacobians); free(values); free(indices);
+        return -1;
+    }
+
+    uint64_t state = task->seed;
+    state = splitmix64(&state) ^ task->iteration;
+    state = splitmix64(&state) ^ chunk;
+    splitmix64(&state);
+
+    for (uint64_t c = c0, k = 0; c < c1; ++c) {
+        for (uint64_t s = 0; s < n; ++s, ++k) {
+            double jacobian = task->volume;
+            uint64_t digits = c;
+            for (unsigned int j = 0; j < d; ++j) {
+                const double *e = task->edges + j * (VEGAS_BINS + 1);
+                const double t = (digits % task->nstrat + uniform(&state)) / task->nstrat * VEGAS_BINS;
+                unsigned int i = (unsigned int)t;
+                if (i >= VEGAS_BINS) { i = VEGAS_BINS - 1; }
+                const double width = *(e + i + 1) - *(e + i);
+                const double u = *(e + i) + (t - i) * width;
+                struct Interval *interval = *(task->intervals + j);
+                *(block + k * d + j) = interval->lower + u * (interval->upper - interval->lower);
+                *(indices + k * d + j) = i;
+                jacobian *= VEGAS_BINS * width;
+                digits /= task->nstrat;
+            }
+            *(jacobians + k) = jacobian;
+        }
+    }
+
+    if (task->native) {
+        for (uint64_t k = 0; k < total; ++k) {
+            *(values + k) = task->f->native(block + k * d, d, task->f->userdata);
+        }
+    } else {
+        for (uint64_t k = 0; k < total; k += task->f->blocksize) {
+            const Py_ssize_t count = (
+                total - k < (uint64_t)task->f->blocksize ? (Py_ssize_t)(total - k) : task->f->blocksize
+            );
+            if (eval_block(task->f, block + k * d, count, d, values + k) == -1) {
+                free(block); free(jacobians); free(values); free(indices);
+                return -1;
+            }
+        }
+    }
+
+    double *bins = task->bins + chunk * d * VEGAS_BINS;
+    double *sums = task->sums + 2 * chunk;
+    memset(bins, 0, d * VEGAS_BINS * sizeof(double));
+    *sums = 0., *(sums + 1) = 0.;
+
+    for (uint64_t c = c0, k = 0; c < c1; ++c) {
+        double s1 = 0., s2 = 0.;
+        for (uint64_t s = 0; s < n; ++s, ++k) {
+            const double v = *(values + k) * *(jacobians + k);
+            s1 += v, s2 += v * v;
+            for (unsigned int j = 0; j < d; ++j) {
+                *(bins + j * VEGAS_BINS + *(indices + k * d + j)) += v * v;
+            }
+        }
+        if (task->pieces > 1) {
+            *sums = s1, *(sums + 1) = s2;
+        } else {
+            const double var = (s2 - s1 * s1 / n) / ((double)n * (n - 1));
+            *sums += s1 / n / task->ncubes;
+            *(sums + 1) += (var > 0. ? var : 0.) / ((double)task->ncubes * task->ncubes);
+        }
+    }
+
+    free(block); free(jacobians); free(values); free(indices);
+
+    return 0;
+
+}
+
+/**
+ * Samples the integrand over one chunk with the GIL released.
+ */
+static void vegas_task(void *context, unsigned int worker, size_t chunk) {
+
+    vegas_chunk((struct VegasTask *)context, chunk);
+
+}
+
+/**
+ * Refines the map of one axis so that every bin carries the same share of the smoothed, damped bin
+ * weights, concentrating bins where the integrand is large.
+ *
+ * @param edges The `VEGAS_BINS + 1` edges of the bins in the unit interval
+ * @param weights The sum of the squared weighted values of the integrand in each bin
+ */
+static void refine_map(double *edges, const double *weights) {
+
+    double smoothed[VEGAS_BINS], r[VEGAS_BINS], total = 0., rtotal = 0.;
+
+    for (unsigned int i = 0; i < VEGAS_BINS; ++i) {
+        const double sum = (
+            *(weights + i) + (i ? *(weights + i - 1) : 0.) + (i + 1 < VEGAS_BINS ? *(weights + i + 1) : 0.)
+        );
+        smoothed[i] = sum / (i && i + 1 < VEGAS_BINS ? 3 : 2);
+        total += smoothed[i];
+    }
+    if (!(total > 0.)) { return; }
+
+    for (unsigned int i = 0; i < VEGAS_BINS; ++i) {
+        const double w = smoothed[i] / total;
+        r[i] = w > 0. && w < 1. ? pow((w - 1) / log(w), VEGAS_ALPHA) : w;
+        rtotal += r[i];
+    }
+
+    double refined[VEGAS_BINS + 1];
+    refined[0] = 0., refined[VEGAS_BINS] = 1.;
+
+    const double share = rtotal / VEGAS_BINS;
+    double acc = 0.;
+    unsigned int k = 0;
+    for (unsigned int i = 1; i < VEGAS_BINS; ++i) {
+        const double target = i * share;
+        while (k + 1 < VEGAS_BINS && acc + r[k] < target) { acc += r[k++]; }
+        const double frac = r[k] > 0. ? (target - acc) / r[k] : 0.;
+        refined[i] = *(edges + k) + (frac < 1. ? frac : 1.) * (*(edges + k + 1) - *(edges + k));
+    }
+
+    memcpy(edges, refined, (VEGAS_BINS + 1) * sizeof(double));
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables by the VEGAS algorithm.
+ *
+ * Every iteration draws about `neval` samples, stratified over hypercubes of the unit cube and mapped
+ * to the domain of integration through a separable piecewise-linear map with `VEGAS_BINS` bins per
+ * axis. After each iteration the map is refined from the squared values of the integrand in each bin.
+ * The estimates of all iterations are combined with inverse-variance weights, and their consistency is
+ * measured by the chi-squared per degree of freedom.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param intervals The intervals spanning the domain of integration
+ * @param d The number of dimensions in the domain of `f`
+ * @param neval The number of samples per iteration
+ * @param niter The number of iterations
+ * @param seed The seed of the random samples
+ * @param nthreads The number of threads to use if `f` is native
+ * @param res The location to which to write the integral estimate
+ * @param err The location to which to write the error estimate
+ * @param chi2 The location to which to write the chi-squared per degree of freedom
+ * @return `0` upon success, or `-1` upon failure
+ */
+short vegas(
+    struct Function *f, struct Interval **intervals, unsigned int d, uint64_t neval, unsigned int niter,
+    uint64_t seed, unsigned int nthreads, double *res, double *err, double *chi2
+) {
+
+    if (d == 0 || neval < 2 || niter == 0) {
+        PyErr_SetString(PyExc_ValueError, "Expected at least one interval, two samples and one iteration");
+        return -1;
+    }
+    if (bounded(intervals, d) == -1) { return -1; }
+
+    struct VegasTask task = {
+        .f = f, .intervals = intervals, .d = d, .volume = 1., .seed = seed,
+        .native = f->type == NATIVE && nthreads > 1, .failed = 0
+    };
+    for (unsigned int j = 0; j < d; ++j) {
+        task.volume *= (*(intervals + j))->upper - (*(intervals + j))->lower;
+    }
+
+    task.nstrat = (uint64_t)pow(neval / 2., 1. / d) + 1;
+    do {
+        --task.nstrat, task.ncubes = 1;
+        for (unsigned int j = 0; j < d && task.ncubes <= neval / 2; ++j) { task.ncubes *= task.nstrat; }
+    } while (task.nstrat > 1 && task.ncubes > neval / 2);
+    if (task.nstrat < 1) { task.nstrat = 1, task.ncubes = 1; }
+    task.npc = neval / task.ncubes;
+
+    const uint64_t target = neval / 256 > NATIVE_BLOCKSIZE ? neval / 256 : NATIVE_BLOCKSIZE;
+    task.pieces = (task.npc + target - 1) / target;
+    task.cubes = task.pieces > 1 ? 1 : target / task.npc;
+    const size_t nchunks = (
+        task.pieces > 1 ? task.ncubes * task.pieces : (task.ncubes + task.cubes - 1) / task.cubes
+    );
+
+    double *edges = (double *)malloc(d * (VEGAS_BINS + 1) * sizeof(double));
+    double *weights = (double *)malloc(d * VEGAS_BINS * sizeof(double));
+    task.sums = (double *)malloc(2 * nchunks * sizeof(double));
+    task.bins = (double *)malloc(nchunks * d * VEGAS_BINS * sizeof(double));
+    if (!edges || !weights || !task.sums || !task.bins) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(edges); free(weights); free(task.sums); free(task.bins);
+        return -1;
+    }
+    for (unsigned int j = 0; j < d; ++j) {
+        for (unsigned int i = 0; i <= VEGAS_BINS; ++i) {
+            *(edges + j * (VEGAS_BINS + 1) + i) = (double)i / VEGAS_BINS;
+        }
+    }
+    task.edges = edges;
+
+    double wsum = 0., wmean = 0., wsq = 0.;
+    *res = 0., *err = INFINITY, *chi2 = 0.;
+
+    for (unsigned int iteration = 0; iteration < niter; ++iteration) {
+
+        task.iteration = iteration;
+        short status = 0;
+        if (task.native) {
+            status = parallel_for(nthreads, nchunks, vegas_task, &task);
+        } else {
+            for (size_t chunk = 0; chunk < nchunks && !status; ++chunk) {
+                status = vegas_chunk(&task, chunk);
+            }
+        }
+        if (status == -1 || task.failed) {
+            if (task.failed) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+            free(edges); free(weights); free(task.sums); free(task.bins);
+            return -1;
+        }
+
+        double estimate = 0., variance = 0.;
+        if (task.pieces > 1) {
+            const uint64_t n = task.npc;
+            for (uint64_t c = 0; c < task.ncubes; ++c) {
+                double s1 = 0., s2 = 0.;
+                for (uint64_t p = 0; p < task.pieces; ++p) {
+                    s1 += *(task.sums + 2 * (c * task.pieces + p));
+                    s2 += *(task.sums + 2 * (c * task.pieces + p) + 1);
+                }
+                const double var = (s2 - s1 * s1 / n) / ((double)n * (n - 1));
+                estimate += s1 / n / task.ncubes;
+                variance += (var > 0. ? var : 0.) / ((double)task.ncubes * task.ncubes);
+            }
+        } else {
+            for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+                estimate += *(task.sums + 2 * chunk), variance += *(task.sums + 2 * chunk + 1);
+            }
+        }
+
+        if (!(variance > 0.)) {
+            *res = estimate, *err = 0., *chi2 = 0.;
+            break;
+        }
+        wsum += 1 / variance, wmean += estimate / variance, wsq += estimate * estimate / variance;
+        *res = wmean / wsum, *err = sqrt(1 / wsum);
+        *chi2 = iteration ? (wsq - wmean * wmean / wsum) / iteration : 0.;
+
+        memset(weights, 0, d * VEGAS_BINS * sizeof(double));
+        for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+            for (unsigned int i = 0; i < d * VEGAS_BINS; ++i) {
+                *(weights + i) += *(task.bins + chunk * d * VEGAS_BINS + i);
+            }
+        }
+        for (unsigned int j = 0; j < d; ++j) {
+            refine_map(edges + j * (VEGAS_BINS + 1), weights + j * VEGAS_BINS);
+        }
+
+    }
+
+    free(edges); free(weights); free(task.sums); free(task.bins);
+
+    return 0;
+
+}
+
+/**
+ * Integrates a sum of products of functions of one real variable over a tensor-product grid. Each
+ * factor is summed along its own axis with the weights of the grid, so that a term costs as many
+ * evaluations as there are domain elements along all axes rather than in the whole grid.
+ *
+ * @param fs The row-major array of `nterms` terms, each with one factor per axis of `grid`
+ * @param nterms The number of terms
+ * @param grid The grid of domain elements and weights
+ * @param res The location to which to write the integral estimate
+ * @return `0` upon success, or `-1` upon failure
+ */
+short separable(struct Function **fs, unsigned int nterms, struct Grid *grid, double *res) {
+
+    const unsigned int d = grid->d;
+    unsigned int size = 0;
+    for (unsigned int i = 0; i < d; ++i) {
+        if (*(grid->sizes + i) > size) { size = *(grid->sizes + i); }
+    }
+
+    double *values = (double *)calloc(size, sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc(sizeof(struct Reducer));
+    if (!values || !r) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(values); free(r);
+        return -1;
+    }
+
+    *res = 0.;
+    for (unsigned int t = 0; t < nterms; ++t) {
+
+        double product = 1.;
+        for (unsigned int i = 0; i < d; ++i) {
+
+            struct Function *f = *(fs + t * d + i);
+            const unsigned int n = *(grid->sizes + i);
+            for (unsigned int k = 0; k < n; k += f->blocksize) {
+                const Py_ssize_t count = n - k < f->blocksize ? (Py_ssize_t)(n - k) : f->blocksize;
+                if (eval_block(f, *(grid->nodes + i) + k, count, 1, values + k) == -1) {
+                    free(values); free(r);
+                    return -1;
+                }
+            }
+
+            reducer_init(r);
+            for (unsigned int k = 0; k < n; ++k) {
+                reducer_add(r, *(*(grid->weights + i) + k) * *(values + k));
+            }
+            product *= reducer_result(r);
+
+        }
+        *res += product;
+
+    }
+
+    free(values); free(r);
+
+    return 0;
+
+}
+
+/**
+ * Returns the time in seconds from an arbitrary origin, on a monotonic clock where available.
+ */
+static double seconds(void) {
+
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables over a tensor-product grid within a
+ * time or evaluation budget, returning the best estimate reached so far.
+ *
+ * The grid is traversed in the order `k * a mod npoints` of its flattened index, where `a` is coprime
+ * with `npoints` and close to its product with the golden ratio, so that every prefix of the traversal
+ * is spread over the whole grid. The estimate is the weighted sum over the domain elements visited so
+ * far, scaled by the ratio of the total weight of the grid to the weight visited. Signals are checked
+ * after each block of `f->blocksize` domain elements.
+ *
+ * @param f A representation of a mathematical function of several real variables
+ * @param grid The grid of domain elements and weights
+ * @param timeout The time budget in seconds, or `0` for none
+ * @param maxeval The evaluation budget, or `0` for none
+ * @param res The location to which to write the integral estimate
+ * @param fraction The location to which to write the fraction of the grid visited
+ * @return `0` upon success, or `-1` upon failure
+ */
+short progressive(
+    struct Function *f, struct Grid *grid, double timeout, uint64_t maxeval, double *res, double *fraction
+) {
+
+    const unsigned int d = grid->d;
+    const uint64_t n = grid->npoints;
+    const Py_ssize_t N = f->blocksize;
+    const double deadline = timeout > 0 ? seconds() + timeout : INFINITY;
+    const uint64_t limit = maxeval && maxeval < n ? maxeval : n;
+
+    double total = 1.;
+    for (unsigned int i = 0; i < d; ++i) {
+        double sum = 0.;
+        for (unsigned int k = 0; k < *(grid->sizes + i); ++k) { sum += *(*(grid->weights + i) + k); }
+        total *= sum;
+    }
+
+    uint64_t a = (uint64_t)((double)n * PROGRESSIVE_RATIO);
+    if (!a) { a = 1; }
+    while (n > 1 && gcd(a, n) != 1) { ++a; }
+
+    double *block = (double *)calloc(N * d, sizeof(double));
+    double *weights = (double *)calloc(N, sizeof(double));
+    double *values = (double *)calloc(N, sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc(2 * sizeof(struct Reducer));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!block || !weights || !values || !r || !odometer) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
+    }
+    reducer_init(r), reducer_init(r + 1);
+
+    uint64_t visited = 0, index = 0;
+    while (visited < limit) {
+
+        const Py_ssize_t count = limit - visited < (uint64_t)N ? (Py_ssize_t)(limit - visited) : N;
+        for (Py_ssize_t k = 0; k < count; ++k) {
+            seek_odometer(grid, odometer, index);
+            memcpy(block + k * d, odometer->x, d * sizeof(double));
+            *(weights + k) = *(odometer->w + d);
+            index = index >= n - a ? index - (n - a) : index + a;
+        }
+
+        if (eval_block(f, block, count, d, values) == -1 || PyErr_CheckSignals() == -1) {
+            free(block); free(weights); free(values); free(r); free_odometer(odometer);
+            return -1;
+        }
+        for (Py_ssize_t k = 0; k < count; ++k) {
+            reducer_add(r, *(weights + k) * *(values + k));
+            reducer_add(r + 1, *(weights + k));
+        }
+        visited += count;
+
+        if (seconds() >= deadline) { break; }
+
+    }
+
+    const double sum = reducer_result(r), weight = reducer_result(r + 1);
+    *res = visited == n ? sum : weight != 0. ? sum * (total / weight) : 0.;
+    *fraction = n ? (double)visited / (double)n : 1.;
+
+    free(block); free(weights); free(values); free(r); free_odometer(odometer);
+
+    return 0;
+
+}
+
+/**
+ * Evaluates a function at every domain element of a grid, in C order with the last axis fastest.
+ *
+ * @param f The function
+ * @param grid The grid of domain elements
+ * @param values The location to which to write the `grid->npoints` rows of `f->outputs` values
+ * @return `0` upon success, or `-1` upon failure
+ */
+short tabulate(struct Function *f, struct Grid *grid, double *values) {
+
+    const unsigned int d = grid->d;
+    const Py_ssize_t N = f->blocksize;
+    double *block = (double *)calloc(N * d, sizeof(double));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!block || !odometer) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free_odometer(odometer);
+        return -1;
+    }
+
+    seek_odometer(grid, odometer, 0);
+    for (uint64_t radix = 0; radix < grid->npoints; radix += N) {
+        const uint64_t remaining = grid->npoints - radix;
+        const Py_ssize_t count = remaining < (uint64_t)N ? (Py_ssize_t)remaining : N;
+        for (Py_ssize_t k = 0; k < count; ++k) {
+            memcpy(block + k * d, odometer->x, d * sizeof(double));
+            step_odometer(grid, odometer);
+        }
+        if (eval_block(f, block, count, d, values + radix * f->outputs) == -1) {
+            free(block); free_odometer(odometer);
+            return -1;
+        }
+    }
+
+    free(block); free_odometer(odometer);
+
+    return 0;
+
+}
+
+/**
+ * Tabulates the cumulative integral of a function along some axes in a single pass. The function is
+ * evaluated once on the grid of the trapezoidal rule, or of a Riemann rule per interval, and the
+ * values are then integrated cumulatively along each chosen axis with a parallel prefix sum.
+ *
+ * The result holds the cumulative integral at every endpoint `0, 1, ..., n` of the chosen axes, and
+ * the function values at every node of the other axes, in C order. Its size along an axis is thus
+ * `n + 1`, except `n` for an axis with a Riemann rule that is not integrated. Functions with several
+ * values have a last axis of `f->outputs` values.
+ *
+ * @param f The function
+ * @param grid The grid of the trapezoidal rule, or of the Riemann rules, over the intervals
+ * @param intervals The intervals of integration
+ * @param rrules The Riemann rule of each interval, or `NULL` for the trapezoidal rule
+ * @param axes Whether to integrate along each axis
+ * @param nthreads The number of threads to use for the prefix sums
+ * @param res The location to which to write the result
+ * @return `0` upon success, or `-1` upon failure
+ */
+short cumulative(
+    struct Function *f, struct Grid *grid, struct Interval **intervals, enum RiemannRules *rrules,
+    const short *axes, unsigned int nthreads, double *res
+) {
+
+    const unsigned int d = grid->d;
+    if (d >= PyBUF_MAX_NDIM) {
+        PyErr_Format(PyExc_ValueError, "Expected fewer than %d intervals", PyBUF_MAX_NDIM);
+        return -1;
+    }
+
+    unsigned int last = d;
+    for (unsigned int i = 0; i < d; ++i) {
+        if (*(axes + i)) { last = i; }
+    }
+
+    const int ndim = d + (f->outputs > 1);
+    const uint64_t nvalues = grid->npoints * f->outputs;
+    double *values = last == d ? res : (double *)malloc((nvalues ? nvalues : 1) * sizeof(double));
+    if (!values) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return -1;
+    }
+    if (tabulate(f, grid, values) == -1) {
+        if (values != res) { free(values); }
+        return -1;
+    }
+
+    Py_ssize_t shape[PyBUF_MAX_NDIM], strides[PyBUF_MAX_NDIM];
+    for (unsigned int i = 0; i < d; ++i) { shape[i] = *(grid->sizes + i); }
+    shape[d] = f->outputs;
+
+    const enum SampleRule rule = rrules ? SAMPLE_RECTANGLE : SAMPLE_TRAPEZOID;
+    for (unsigned int i = 0; i <= last && last < d; ++i) {
+
+        if (!*(axes + i)) { continue; }
+
+        Py_ssize_t size = 1, stride = sizeof(double);
+        for (int j = ndim - 1; j >= 0; stride *= shape[j--]) {
+            strides[j] = stride;
+            size *= shape[j] + (j == i && rule == SAMPLE_RECTANGLE);
+        }
+
+        double *out = i == last ? res : (double *)malloc((size ? size : 1) * sizeof(double));
+        if (!out) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        const double dx = ((*(intervals + i))->upper - (*(intervals + i))->lower) / (*(intervals + i))->n;
+        const char *src = (const char *)values;
+        if (!out || cumulate_axis(src, ndim, shape, strides, i, rule, dx, NULL, nthreads, out)) {
+            if (out != res) { free(out); }
+            free(values);
+            return -1;
+        }
+
+        free(values);
+        values = out, shape[i] += rule == SAMPLE_RECTANGLE;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * The shared state of a parameter sweep of a native function, in chunks of `SWEEP_CHUNK` parameters.
+ */
+struct SweepTask {
+    struct Function *f;
+    struct Grid *grid;
+    const double *params;
+    Py_ssize_t P;
+    unsigned int q;
+    double *res;
+    size_t first;
+    short failed;
+};
+
+/**
+ * Integrates a native function for one chunk of parameters of the current batch in a single traversal
+ * of the grid.
+ */
+static void sweep_chunk(void *context, unsigned int worker, size_t chunk) {
+
+    struct SweepTask *task = (struct SweepTask *)context;
+    struct Grid *grid = task->grid;
+    const unsigned int d = grid->d, q = task->q;
+    const Py_ssize_t lo = (Py_ssize_t)(task->first + chunk) * SWEEP_CHUNK;
+    const Py_ssize_t count = task->P - lo < SWEEP_CHUNK ? task->P - lo : SWEEP_CHUNK;
+
+    struct Reducer *r = (struct Reducer *)malloc(count * sizeof(struct Reducer));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!r || !odometer) {
+        free(r); free_odometer(odometer);
+        task->failed = 1;
+        return;
+    }
+    for (Py_ssize_t j = 0; j < count; ++j) { reducer_init(r + j); }
+
+    const double *p = task->params + lo * q;
+    seek_odometer(grid, odometer, 0);
+    for (uint64_t k = 0; k < grid->npoints; ++k) {
+        const double w = *(odometer->w + d);
+        for (Py_ssize_t j = 0; j < count; ++j) {
+            reducer_add(r + j, w * task->f->parametric(odometer->x, d, p + j * q, q, task->f->userdata));
+        }
+        step_odometer(grid, odometer);
+    }
+    for (Py_ssize_t j = 0; j < count; ++j) { *(task->res + lo + j) = reducer_result(r + j); }
+
+    free(r); free_odometer(odometer);
+
+}
+
+/**
+ * Integrates a family of functions over a tensor-product grid for each of a sequence of parameters.
+ * The domain elements and weights are generated once per traversal of the grid, and the function is
+ * evaluated for blocks of domain elements and all parameters at once. Native functions are integrated
+ * on multiple threads in chunks of parameters, with the GIL released and signals checked after each
+ * chunk per thread. The integral for each parameter is bit-identical to the one computed by
+ * `tensor_sum`.
+ *
+ * @param f A representation of a family of functions, as parsed by `parse_parametric`
+ * @param grid The grid of domain elements and weights
+ * @param params The row-major array of `P` parameters
+ * @param P The number of parameters
+ * @param q The number of components of each parameter
+ * @param nthreads The number of threads to use if `f` is native
+ * @param res The location to which to write the `P` integrals
+ * @return `0` upon success, or `-1` upon failure
+ */
+short sweep(
+    struct Function *f, struct Grid *grid, double *params, Py_ssize_t P, unsigned int q,
+    unsigned int nthreads, double *res
+) {
+
+    if (f->type == NATIVE) {
+        struct SweepTask task = { f, grid, params, P, q, res, 0, 0 };
+        const size_t nchunks = (size_t)((P + SWEEP_CHUNK - 1) / SWEEP_CHUNK);
+        for (; task.first < nchunks; task.first += nthreads) {
+            const size_t count = nchunks - task.first < nthreads ? nchunks - task.first : nthreads;
+            if (parallel_for(nthreads, count, sweep_chunk, &task) == -1) { return -1; }
+            if (task.failed) {
+                PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+                return -1;
+            }
+            if (PyErr_CheckSignals() == -1) { return -1; }
+        }
+        return 0;
+    }
+
+    const unsigned int d = grid->d;
+    const Py_ssize_t N = f->blocksize;
+    double *block = (double *)calloc(N * d, sizeof(double));
+    double *weights = (double *)calloc(N, sizeof(double));
+    double *values = (double *)calloc(N * (P ? P : 1), sizeof(double));
+    struct Reducer *r = (struct Reducer *)malloc((P ? P : 1) * sizeof(struct Reducer));
+    struct Odometer *odometer = new_odometer(grid);
+    if (!block || !weights || !values || !r || !odometer) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(block); free(weights); free(values); free(r); free_odometer(odometer);
+        return -1;
+    }
+    for (Py_ssize_t j = 0; j < P; ++j) { reducer_init(r + j); }
+
+    seek_odometer(grid, odometer, 0);
+    for (uint64_t radix = 0; radix < grid->npoints; radix += N) {
+
+        const uint64_t remaining = grid->npoints - radix;
+        const Py_ssize_t count = remaining < (uint64_t)N ? (Py_ssize_t)remaining : N;
+        for (Py_ssize_t k = 0; k < count; ++k) {
+            memcpy(block + k * d, odometer->x, d * sizeof(double));
+            *(weights + k) = *(odometer->w + d);
+            step_odometer(grid, odometer);
+        }
+
+        if (eval_parametric(f, block, count, d, params, P, q, values) == -1) {
+            free(block); free(weights); free(values); free(r); free_odometer(odometer);
+            return -1;
+        }
+        for (Py_ssize_t j = 0; j < P; ++j) {
+            for (Py_ssize_t k = 0; k < count; ++k) {
+                reducer_add(r + j, *(weights + k) * *(values + j * count + k));
+            }
+        }
+
+    }
+    for (Py_ssize_t j = 0; j < P; ++j) { *(res + j) = reducer_result(r + j); }
+
+    free(block); free(weights); free(values); free(r); free_odometer(odometer);
+
+    return 0;
+
+}
+
+/**
+ * Parses the factors of a separable integrand, either a sequence of one callable per axis, or a
+ * sequence of such sequences for a sum of separable terms.
+ *
+ * @param ob_fs The factors of the integrand
+ * @param d The number of axes
+ * @param blocksize The number of domain elements per call of vectorized factors, or `0`
+ * @param nterms The location to which to write the number of terms
+ * @return A dynamically allocated row-major array of factors, or `NULL` upon failure
+ */
+static struct Function **parse_terms(
+    PyObject *ob_fs, unsigned int d, Py_ssize_t blocksize, unsigned int *nterms
+) {
+
+    PyObject *terms = PySequence_Fast(ob_fs, "Expected a sequence of callables");
+    if (!terms) { return NULL; }
+
+    const Py_ssize_t size = PySequence_Fast_GET_SIZE(terms);
+    PyObject *first = size ? PySequence_Fast_GET_ITEM(terms, 0) : NULL;
+    const short nested = first && (PyList_Check(first) || PyTuple_Check(first));
+    *nterms = nested ? (unsigned int)size : 1;
+
+    struct Function **fs = (struct Function **)calloc((size_t)*nterms * d, sizeof(struct Function *));
+    if (!fs) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        Py_DECREF(terms);
+        return NULL;
+    }
+
+    for (unsigned int t = 0; t < *nterms; ++t) {
+
+        PyObject *factors = PySequence_Fast(
+            nested ? PySequence_Fast_GET_ITEM(terms, t) : terms, "Expected a sequence of callables"
+        );
+        short failed = !factors;
+        if (factors && PySequence_Fast_GET_SIZE(factors) != d) {
+            PyErr_SetString(PyExc_ValueError, "Expected one factor per interval in each term");
+            failed = 1;
+        }
+        for (unsigned int i = 0; i < d && !failed; ++i) {
+            failed = !(*(fs + t * d + i) = parse_function(PySequence_Fast_GET_ITEM(factors, i), blocksize));
+        }
+        Py_XDECREF(factors);
+
+        if (failed) {
+            for (unsigned int k = 0; k < *nterms * d; ++k) { free_function(*(fs + k)); }
+            free(fs);
+            Py_DECREF(terms);
+            return NULL;
+        }
+
+    }
+    Py_DECREF(terms);
+
+    return fs;
+
+}
+
+/**
+ * Builds the grid of a trapezoidal rule if `ob_rrules` is `None`, or of a rule per interval otherwise.
+ */
+static struct Grid *parse_grid(struct Interval **intervals, unsigned int d, PyObject *ob_rrules) {
+
+    if (ob_rrules == Py_None) { return trapezoidal_grid(intervals, d); }
+    if (PySequence_Check(ob_rrules) && PySequence_Size(ob_rrules) != d) {
+        PyErr_SetString(PyExc_ValueError, "Expected one Riemann rule per interval");
+        return NULL;
+    }
+
+    enum QuadratureRules *rules = parse_rules(ob_rrules);
+    struct Grid *grid = rules ? tensor_grid(intervals, rules, d) : NULL;
+    free(rules);
+
+    return grid;
+
+}
+
+/**
+ * Integrates a separable integrand over a grid, returning a 'float' object.
+ */
+static PyObject *separable_value(PyObject *ob_fs, struct Grid *grid, Py_ssize_t blocksize) {
+
+    unsigned int nterms;
+    struct Function **fs = parse_terms(ob_fs, grid->d, blocksize, &nterms);
+    if (!fs) { return NULL; }
+
+    double res;
+    PyObject *value = separable(fs, nterms, grid, &res) ? NULL : PyFloat_FromDouble(res);
+
+    for (unsigned int k = 0; k < nterms * grid->d; ++k) { free_function(*(fs + k)); }
+    free(fs);
+
+    return value;
+
+}
+
+/**
+ * Parses the spacing of `n` samples along an axis. `ob_x` is either `None` for a unit spacing, a
+ * 'float' spacing, or the coordinates of the samples as a one-dimensional buffer of 'float' values
+ * or a sequence of 'float' objects. `*x` is set to the coordinates, or to `NULL` for a spacing.
+ */
+static short parse_coordinates(PyObject *ob_x, Py_ssize_t n, double *dx, double **x) {
+
+    *dx = 1., *x = NULL;
+    if (ob_x == Py_None) { return 0; }
+    if (PyFloat_Check(ob_x) || PyLong_Check(ob_x)) {
+        *dx = PyFloat_AsDouble(ob_x);
+        return *dx == -1. && PyErr_Occurred() ? -1 : 0;
+    }
+
+    double *coords = (double *)calloc(n ? n : 1, sizeof(double));
+    if (!coords) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return -1;
+    }
+
+    Py_buffer view;
+    if (PyObject_CheckBuffer(ob_x) && !PyObject_GetBuffer(ob_x, &view, PyBUF_RECORDS_RO)) {
+        const char *format = view.format ? view.format : "B";
+        if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+        if (strcmp(format, "d") || view.ndim != 1 || *view.shape != n) {
+            PyErr_SetString(PyExc_ValueError, "Expected a one-dimensional buffer of 'float' coordinates");
+            PyBuffer_Release(&view); free(coords);
+            return -1;
+        }
+        for (Py_ssize_t k = 0; k < n; ++k) {
+            *(coords + k) = *(const double *)((const char *)view.buf + k * *view.strides);
+        }
+        PyBuffer_Release(&view);
+        *x = coords;
+        return 0;
+    }
+    PyErr_Clear();
+
+    PyObject *seq = PySequence_Fast(ob_x, "Expected a spacing or a sequence of coordinates");
+    if (!seq || PySequence_Fast_GET_SIZE(seq) != n) {
+        if (seq) { PyErr_SetString(PyExc_ValueError, "Expected one coordinate per sample"); }
+        Py_XDECREF(seq); free(coords);
+        return -1;
+    }
+    for (Py_ssize_t k = 0; k < n; ++k) {
+        *(coords + k) = PyFloat_AsDouble(PySequence_Fast_GET_ITEM(seq, k));
+        if (*(coords + k) == -1. && PyErr_Occurred()) {
+            Py_DECREF(seq); free(coords);
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+    *x = coords;
+
+    return 0;
+
+}
+
+/**
+ * Computes the weights of a sample rule along an axis of `n` samples spaced as given by `ob_x`.
+ */
+static double *parse_spacing(PyObject *ob_x, Py_ssize_t n, enum SampleRule rule) {
+
+    double dx, *x;
+    if (parse_coordinates(ob_x, n, &dx, &x) == -1) { return NULL; }
+
+    double *w = (double *)calloc(n ? n : 1, sizeof(double));
+    if (!w) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(x);
+        return NULL;
+    }
+
+    short status = sample_weights(rule, n, dx, x, w);
+    free(x);
+    if (status == -1) {
+        free(w);
+        return NULL;
+    }
+
+    return w;
+
+}
+
+/**
+ * Parses the axes along which to integrate samples with `ndim` dimensions. `ob_axis` is either `None`
+ * for every axis, an 'int' object, or a sequence of 'int' objects; negative axes count from the end.
+ */
+static short parse_axes(PyObject *ob_axis, int ndim, int *axes, int *naxes) {
+
+    if (ob_axis == Py_None) {
+        for (int j = 0; j < ndim; ++j) { *(axes + j) = j; }
+        *naxes = ndim;
+        return 0;
+    }
+
+    PyObject *seq = PyLong_Check(ob_axis) ? PyTuple_Pack(1, ob_axis) : PySequence_Tuple(ob_axis);
+    if (!seq) { return -1; }
+    if (PyTuple_GET_SIZE(seq) > ndim) {
+        PyErr_SetString(PyExc_ValueError, "Expected at most one axis per dimension of the samples");
+        Py_DECREF(seq);
+        return -1;
+    }
+    *naxes = (int)PyTuple_GET_SIZE(seq);
+
+    short seen[PyBUF_MAX_NDIM] = { 0 };
+    for (int i = 0; i < *naxes; ++i) {
+        long axis = PyLong_AsLong(PyTuple_GET_ITEM(seq, i));
+        if (axis == -1 && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            return -1;
+        }
+        if (axis < 0) { axis += ndim; }
+        if (axis < 0 || axis >= ndim || seen[axis]) {
+            PyErr_SetString(PyExc_ValueError, "Expected distinct axes within the dimensions of the samples");
+            Py_DECREF(seq);
+            return -1;
+        }
+        seen[axis] = 1, *(axes + i) = (int)axis;
+    }
+    Py_DECREF(seq);
+
+    return 0;
+
+}
+
+/**
+ * Wraps a 'bytearray' of 'float' values into a `memoryview` of the given shape, stealing the
+ * reference to the 'bytearray'. Empty results are one-dimensional, as `memoryview` objects cannot be
+ * cast to shapes with zeros.
+ */
+static PyObject *shaped_view(PyObject *bytes, int ndim, const Py_ssize_t *shape) {
+
+    if (!PyByteArray_GET_SIZE(bytes)) {
+        PyObject *memory = PyMemoryView_FromObject(bytes);
+        PyObject *value = memory ? PyObject_CallMethod(memory, "cast", "s", "d") : NULL;
+        Py_XDECREF(memory); Py_DECREF(bytes);
+        return value;
+    }
+
+    PyObject *ob_shape = PyTuple_New(ndim);
+    for (int j = 0; ob_shape && j < ndim; ++j) {
+        PyObject *size = PyLong_FromSsize_t(*(shape + j));
+        if (!size) { Py_CLEAR(ob_shape); break; }
+        PyTuple_SET_ITEM(ob_shape, j, size);
+    }
+    PyObject *memory = ob_shape ? PyMemoryView_FromObject(bytes) : NULL;
+    PyObject *value = memory ? PyObject_CallMethod(memory, "cast", "sO", "d", ob_shape) : NULL;
+    Py_XDECREF(ob_shape); Py_XDECREF(memory); Py_DECREF(bytes);
+
+    return value;
+
+}
+
+/**
+ * Reduces the axes of a buffer of samples that have weights, from the last to the first, each into a
+ * C-contiguous array with the GIL released. The last reduction writes directly into the 'bytearray'
+ * backing the result. Returns a 'float' object if every axis is reduced, and a `memoryview` of
+ * 'float' values of the remaining shape otherwise.
+ */
+static PyObject *reduce_samples(Py_buffer *view, double **weights, int ndim_out) {
+
+    int ndim = view->ndim;
+    Py_ssize_t shape[PyBUF_MAX_NDIM], strides[PyBUF_MAX_NDIM];
+    memcpy(shape, view->shape, ndim * sizeof(Py_ssize_t));
+    memcpy(strides, view->strides, ndim * sizeof(Py_ssize_t));
+
+    PyObject *bytes = NULL;
+    const char *src = (const char *)view->buf;
+
+    for (int axis = ndim - 1; axis >= 0; --axis) {
+
+        if (!*(weights + axis)) { continue; }
+
+        Py_ssize_t size = 1;
+        for (int j = 0; j < ndim; ++j) { size *= j == axis ? 1 : shape[j]; }
+
+        double *out = NULL;
+        if (ndim == ndim_out + 1 && ndim_out) {
+            bytes = PyByteArray_FromStringAndSize(NULL, size * (Py_ssize_t)sizeof(double));
+            out = bytes ? (double *)PyByteArray_AS_STRING(bytes) : NULL;
+        } else if (!(out = (double *)malloc((size ? size : 1) * sizeof(double)))) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        }
+        if (!out) {
+            if (src != view->buf) { free((void *)src); }
+            return NULL;
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+        reduce_axis(src, ndim, shape, strides, axis, *(weights + axis), out);
+        Py_END_ALLOW_THREADS
+
+        if (src != view->buf) { free((void *)src); }
+        src = (const char *)out;
+
+        memmove(shape + axis, shape + axis + 1, (ndim - axis - 1) * sizeof(Py_ssize_t));
+        Py_ssize_t stride = sizeof(double);
+        for (int j = --ndim - 1; j >= 0; stride *= shape[j--]) { strides[j] = stride; }
+
+    }
+
+    if (!ndim_out) {
+        PyObject *value = PyFloat_FromDouble(*(const double *)src);
+        free((void *)src);
+        return value;
+    }
+
+    return shaped_view(bytes, ndim_out, shape);
+
+}
+
+/**
+ * Integrates a buffer of samples cumulatively with the trapezoidal rule along the axes that have a
+ * spacing, from the first to the last. Successive axes alternate between the 'bytearray' backing the
+ * result, a `memoryview` of 'float' values of the shape of the samples, and a scratch buffer, starting
+ * with whichever makes the last axis write into the result, so that no axis is scanned in place.
+ */
+static PyObject *cumulate_samples(
+    Py_buffer *view, const short *axes, const double *dx, double **x, unsigned int nthreads
+) {
+
+    const int ndim = view->ndim;
+    Py_ssize_t size = 1, strides[PyBUF_MAX_NDIM];
+    memcpy(strides, view->strides, ndim * sizeof(Py_ssize_t));
+    for (int j = 0; j < ndim; ++j) { size *= *(view->shape + j); }
+
+    int naxes = 0;
+    for (int j = 0; j < ndim; ++j) { naxes += *(axes + j) != 0; }
+
+    PyObject *bytes = PyByteArray_FromStringAndSize(NULL, size * (Py_ssize_t)sizeof(double));
+    if (!bytes) { return NULL; }
+    double *res = (double *)PyByteArray_AS_STRING(bytes);
+    double *tmp = NULL;
+    if (naxes > 1 && !(tmp = (double *)malloc((size ? size : 1) * sizeof(double)))) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        Py_DECREF(bytes);
+        return NULL;
+    }
+
+    const char *src = (const char *)view->buf;
+    double *out = naxes % 2 ? res : tmp;
+    for (int j = 0; j < ndim; ++j) {
+
+        if (!*(axes + j)) { continue; }
+
+        if (cumulate_axis(
+            src, ndim, view->shape, strides, j, SAMPLE_TRAPEZOID, *(dx + j), *(x + j), nthreads, out
+        )) {
+            free(tmp); Py_DECREF(bytes);
+            return NULL;
+        }
+
+        src = (const char *)out;
+        out = out == res ? tmp : res;
+        Py_ssize_t stride = sizeof(double);
+        for (int k = ndim - 1; k >= 0; stride *= *(view->shape + k--)) { strides[k] = stride; }
+
+    }
+    free(tmp);
+
+    return shaped_view(bytes, ndim, view->shape);
+
+}
+
+/**
+ * Integrates samples given as a buffer of 'float' values along one or more axes with a rule, without
+ * copying the samples. `args` holds the samples, then optionally the spacing or coordinates, and the
+ * axes, `-1` by default. With several axes, a tuple with one entry per axis gives each its own
+ * spacing or coordinates.
+ */
+static PyObject *integrate_samples(PyObject *args, enum SampleRule rule) {
+
+    PyObject *ob_y;
+    PyObject *ob_x = Py_None;
+    PyObject *ob_axis = NULL;
+    if (!PyArg_ParseTuple(args, "O|OO", &ob_y, &ob_x, &ob_axis)) { return NULL; }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(ob_y, &view, PyBUF_RECORDS_RO)) { return NULL; }
+    const char *format = view.format ? view.format : "B";
+    if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+    if (strcmp(format, "d") || view.ndim < 1) {
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'float' samples with at least one dimension");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    int naxes = 1, axes[PyBUF_MAX_NDIM] = { view.ndim - 1 };
+    double *weights[PyBUF_MAX_NDIM] = { NULL };
+    short status = ob_axis ? parse_axes(ob_axis, view.ndim, axes, &naxes) : 0;
+
+    const short per_axis = naxes > 1 && PyTuple_Check(ob_x) && PyTuple_GET_SIZE(ob_x) == naxes;
+    for (int i = 0; !status && i < naxes; ++i) {
+        PyObject *ob_spacing = per_axis ? PyTuple_GET_ITEM(ob_x, i) : ob_x;
+        weights[*(axes + i)] = parse_spacing(ob_spacing, *(view.shape + *(axes + i)), rule);
+        if (!weights[*(axes + i)]) { status = -1; }
+    }
+
+    PyObject *value = status ? NULL : reduce_samples(&view, weights, view.ndim - naxes);
+
+    for (int j = 0; j < view.ndim; ++j) { free(weights[j]); }
+    PyBuffer_Release(&view);
+
+    return value;
+
+}
+
+/**
+ * Determines the number of values of an integrand by evaluating it at the first node of a grid, so
+ * that integrands `f: R^d -> R^m` can be integrated in a single traversal. That node is the first
+ * domain element of any traversal of the grid, which reuses its values.
+ */
+static short probe_grid(struct Function *f, struct Grid *grid) {
+
+    double *x = (double *)calloc(grid->d ? grid->d : 1, sizeof(double));
+    if (!x) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return -1;
+    }
+    for (unsigned int i = 0; i < grid->d; ++i) { *(x + i) = **(grid->nodes + i); }
+
+    short err = probe_function(f, x, grid->d);
+    free(x);
+
+    return err;
+
+}
+
+/**
+ * Converts the integrals of an integrand with `m` values into a 'float' object if `m` is `1`, or a
+ * 'tuple' of 'float' objects otherwise.
+ */
+static PyObject *integral_value(const double *res, unsigned int m) {
+
+    if (m == 1) { return PyFloat_FromDouble(*res); }
+
+    PyObject *tuple = PyTuple_New(m);
+    for (unsigned int j = 0; tuple && j < m; ++j) {
+        PyObject *item = PyFloat_FromDouble(*(res + j));
+        if (!item) { Py_CLEAR(tuple); break; }
+        PyTuple_SET_ITEM(tuple, j, item);
+    }
+
+    return tuple;
+
+}
+
+/**
+ * Integrates a function with one or several values over a grid, probing the number of values at the
+ * first node of the grid.
+ */
+static PyObject *grid_value(struct Grid *grid, struct Function *f, unsigned int nthreads) {
+
+    short probed = probe_grid(f, grid);
+    double *res = probed ? NULL : (double *)calloc(f->outputs, sizeof(double));
+    if (!res) {
+        if (!probed) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        return NULL;
+    }
+
+    PyObject *value = tensor_sum(f, grid, nthreads, res) ? NULL : integral_value(res, f->outputs);
+    free(res);
+
+    return value;
+
+}
+
+/**
+ * Parses parameters given as a buffer of 'float' values of shape `(P,)` or `(P, q)`, or as a sequence
+ * of 'float' objects or of sequences of `q` 'float' objects.
+ *
+ * @param ob_params The parameters
+ * @param P The location to which to write the number of parameters
+ * @param q The location to which to write the number of components of each parameter
+ * @return A dynamically allocated row-major array of parameters, or `NULL` upon failure
+ */
+static double *parse_parameters(PyObject *ob_params, Py_ssize_t *P, unsigned int *q) {
+
+    Py_buffer view;
+    if (PyObject_CheckBuffer(ob_params) && !PyObject_GetBuffer(ob_params, &view, PyBUF_RECORDS_RO)) {
+
+        const char *format = view.format ? view.format : "B";
+        if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+        if (strcmp(format, "d") || view.ndim < 1 || view.ndim > 2) {
+            PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'float' parameters with one or two axes");
+            PyBuffer_Release(&view);
+            return NULL;
+        }
+        *P = *view.shape, *q = view.ndim == 2 ? (unsigned int)*(view.shape + 1) : 1;
+
+        const Py_ssize_t size = *P * (Py_ssize_t)*q;
+        double *params = (double *)malloc((size ? size : 1) * sizeof(double));
+        if (!params) { PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory"); }
+        for (Py_ssize_t j = 0; params && j < *P; ++j) {
+            for (unsigned int l = 0; l < *q; ++l) {
+                const char *item = (const char *)view.buf + j * *view.strides;
+                if (view.ndim == 2) { item += l * *(view.strides + 1); }
+                *(params + j * *q + l) = *(const double *)item;
+            }
+        }
+        PyBuffer_Release(&view);
+
+        return params;
+
+    }
+    PyErr_Clear();
+
+    PyObject *seq = PySequence_Fast(ob_params, "Expected a sequence of parameters");
+    if (!seq) { return NULL; }
+    *P = PySequence_Fast_GET_SIZE(seq), *q = 1;
+    if (*P) {
+        PyObject *first = PySequence_Fast_GET_ITEM(seq, 0);
+        if (!PyFloat_Check(first) && !PyLong_Check(first)) {
+            Py_ssize_t length = PySequence_Size(first);
+            if (length < 1) {
+                if (!PyErr_Occurred()) { PyErr_SetString(PyExc_ValueError, "Expected non-empty parameters"); }
+                Py_DECREF(seq);
+                return NULL;
+            }
+            *q = (unsigned int)length;
+        }
+    }
+
+    const Py_ssize_t size = *P * (Py_ssize_t)*q;
+    double *params = (double *)malloc((size ? size : 1) * sizeof(double));
+    if (!params) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        Py_DECREF(seq);
+        return NULL;
+    }
+    for (Py_ssize_t j = 0; j < *P; ++j) {
+        PyObject *item = PySequence_Fast_GET_ITEM(seq, j);
+        PyObject *row = PyFloat_Check(item) || PyLong_Check(item)
+            ? NULL : PySequence_Fast(item, "Expected a sequence of 'float' objects");
+        short err = (row ? PySequence_Fast_GET_SIZE(row) : 1) != *q || (!row && PyErr_Occurred());
+        for (unsigned int l = 0; !err && l < *q; ++l) {
+            *(params + j * *q + l) = PyFloat_AsDouble(row ? PySequence_Fast_GET_ITEM(row, l) : item);
+            err = *(params + j * *q + l) == -1. && PyErr_Occurred();
+        }
+        Py_XDECREF(row);
+        if (err) {
+            if (!PyErr_Occurred()) { PyErr_SetString(PyExc_ValueError, "Expected parameters of one length"); }
+            free(params); Py_DECREF(seq);
+            return NULL;
+        }
+    }
+    Py_DECREF(seq);
+
+    return params;
+
+}
+
+/**
+ * Integrates a family of functions over a grid for each of a sequence of parameters, returning a
+ * `memoryview` of the integrals.
+ */
+static PyObject *sweep_value(
+    PyObject *ob_f, struct Grid *grid, PyObject *ob_params, Py_ssize_t blocksize, unsigned int nthreads
+) {
+
+    Py_ssize_t P;
+    unsigned int q;
+    struct Function *f = parse_parametric(ob_f, blocksize);
+    double *params = f ? parse_parameters(ob_params, &P, &q) : NULL;
+    PyObject *bytes = params ? PyByteArray_FromStringAndSize(NULL, P * (Py_ssize_t)sizeof(double)) : NULL;
+    if (!bytes) {
+        free_function(f); free(params);
+        return NULL;
+    }
+
+    if (sweep(f, grid, params, P, q, nthreads, (double *)PyByteArray_AS_STRING(bytes)) == -1) {
+        free_function(f); free(params); Py_DECREF(bytes);
+        return NULL;
+    }
+    free_function(f); free(params);
+
+    return shaped_view(bytes, 1, &P);
+
+}
+
+static PyObject *integral_delta(PyObject *self, PyObject *args) {
+
+    PyObject *ob_intervals;
+    if (!PyArg_ParseTuple(args, "OI", &ob_intervals)) { return NULL; }
+
+    if (!PySequence_Check(ob_intervals)) {
+        PyErr_SetString(PyExc_TypeError, "Expected a sequence of 'Interval' objects");
+        return NULL;
+    }
+
+    unsigned int d;
+    struct Interval **intervals = parse_intervals(ob_intervals, &d);
+    if (!intervals) { return NULL; }
+
+    double result = delta(intervals, d);
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free(intervals);
+
+    return PyFloat_FromDouble(result);
+
+}
+
+static PyObject *riemann_rule(PyObject *self, PyObject *args, RiemannRule rule) {
+
+    PyObject *ob_interval;
+    unsigned int i;
+    if (!PyArg_ParseTuple(args, "OI", &ob_interval, &i)) { return NULL; }
+
+    struct Interval *interval = parse_interval(ob_interval);
+    double *x = (double *)malloc(sizeof(double));
+    if (!interval || !x) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(interval); free(x);
+        return NULL;
+    }
+
+    short err = rule(interval, i, x);
+    if (err < 0) {
+        PyErr_SetString(PyExc_ValueError, "Index of bounds of interval");
+        free(interval); free(x);
+        return NULL;
+    }
+
+    PyObject *res = PyFloat_FromDouble(*x);
+    free(interval); free(x);
+
+    return res;
+
+}
+
+static PyObject *integral_endpoint(
+    PyObject *self, PyObject *args
+) { return riemann_rule(self, args, endpoint); }
+
+static PyObject *integral_left(
+    PyObject *self, PyObject *args
+) { return riemann_rule(self, args, left); }
+
+static PyObject *integral_right(
+    PyObject *self, PyObject *args
+) { return riemann_rule(self, args, right); }
+
+static PyObject *integral_midpoint(
+    PyObject *self, PyObject *args
+) { return riemann_rule(self, args, midpoint); }
+
+static PyObject *integral_riemann(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    PyObject *ob_rrules;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "OOO|nI", &ob_f, &ob_intervals, &ob_rrules, &blocksize, &nthreads)) {
+        return NULL;
+    }
+
+    if (PySequence_Check(ob_intervals) && PySequence_Check(ob_rrules)
+        && PySequence_Size(ob_intervals) != PySequence_Size(ob_rrules)) {
+        PyErr_SetString(PyExc_ValueError, "Expected one Riemann rule per interval");
+        return NULL;
+    }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    enum RiemannRules *rrules = intervals ? parse_rrules(ob_rrules) : NULL;
+    struct Grid *grid = rrules ? riemann_grid(intervals, rrules, d) : NULL;
+    if (!grid) {
+        if (intervals) { for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); } }
+        free_function(f); free(intervals); free(rrules);
+        return NULL;
+    }
+
+    PyObject *value = grid_value(grid, f, nthreads ? nthreads : get_threads());
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals); free(rrules); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_trapezoidal(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "OO|nI", &ob_f, &ob_intervals, &blocksize, &nthreads)) {
+        return NULL;
+    }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    struct Grid *grid = intervals ? trapezoidal_grid(intervals, d) : NULL;
+    if (!grid) {
+        if (intervals) { for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); } }
+        free_function(f); free(intervals);
+        return NULL;
+    }
+
+    PyObject *value = grid_value(grid, f, nthreads ? nthreads : get_threads());
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_quad(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    double epsabs;
+    double epsrel = 0.;
+    int krule = GK21;
+    unsigned int limit = 50;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOd|diIn", &ob_f, &ob_intervals, &epsabs, &epsrel, &krule, &limit, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+
+    double res, err;
+    uint64_t neval;
+    PyObject *value = (
+        quad(f, intervals, d, epsabs, epsrel, (enum KronrodRules)krule, limit, &res, &err, &neval)
+        ? NULL : Py_BuildValue("ddK", res, err, (unsigned long long)neval)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_romberg(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    double epsabs;
+    double epsrel = 0.;
+    unsigned int maxlevel = 12;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOd|dIn", &ob_f, &ob_intervals, &epsabs, &epsrel, &maxlevel, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+
+    double res, err;
+    uint64_t neval, nreused;
+    PyObject *value = (
+        romberg(f, intervals, d, epsabs, epsrel, maxlevel, &res, &err, &neval, &nreused)
+        ? NULL : Py_BuildValue(
+            "ddKK", res, err, (unsigned long long)neval, (unsigned long long)nreused
+        )
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_qmc(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    unsigned long long n;
+    int rule = SOBOL;
+    unsigned int nshifts = 8;
+    unsigned long long seed = 0;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOK|iIKn", &ob_f, &ob_intervals, &n, &rule, &nshifts, &seed, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+
+    double res, err;
+    PyObject *value = (
+        qmc(f, intervals, d, (enum QMCRules)rule, n, nshifts, seed, &res, &err)
+        ? NULL : Py_BuildValue("ddK", res, err, (unsigned long long)n * nshifts)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_vegas(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    unsigned long long neval;
+    unsigned int niter = 10;
+    unsigned long long seed = 0;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOK|IKnI", &ob_f, &ob_intervals, &neval, &niter, &seed, &blocksize, &nthreads
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+
+    double res, err, chi2;
+    PyObject *value = (
+        vegas(f, intervals, d, neval, niter, seed, nthreads ? nthreads : get_threads(), &res, &err, &chi2)
+        ? NULL : Py_BuildValue("ddd", res, err, chi2)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_tensor(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    PyObject *ob_rules;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "OOO|nI", &ob_f, &ob_intervals, &ob_rules, &blocksize, &nthreads)) {
+        return NULL;
+    }
+
+    if (PySequence_Check(ob_intervals) && PySequence_Check(ob_rules)
+        && PySequence_Size(ob_intervals) != PySequence_Size(ob_rules)) {
+        PyErr_SetString(PyExc_ValueError, "Expected one rule per interval");
+        return NULL;
+    }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    enum QuadratureRules *rules = intervals ? parse_rules(ob_rules) : NULL;
+    struct Grid *grid = rules ? tensor_grid(intervals, rules, d) : NULL;
+    if (!grid) {
+        if (intervals) { for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); } }
+        free_function(f); free(intervals); free(rules);
+        return NULL;
+    }
+
+    PyObject *value = grid_value(grid, f, nthreads ? nthreads : get_threads());
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals); free(rules); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_sparse(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    double epsabs;
+    double epsrel = 0.;
+    int rule = CLENSHAW_CURTIS;
+    unsigned int maxlevel = 0;
+    unsigned long long maxeval = 1000000;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOd|diIKn", &ob_f, &ob_intervals, &epsabs, &epsrel, &rule, &maxlevel, &maxeval, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+    if (!maxlevel) { maxlevel = rule == GAUSS_PATTERSON ? GP_LEVELS : CC_LEVELS; }
+
+    double res, err;
+    uint64_t neval;
+    PyObject *value = (
+        sparse(
+            f, intervals, d, epsabs, epsrel, (enum QuadratureRules)rule, maxlevel, maxeval, &res, &err, &neval
+        ) ? NULL : Py_BuildValue("ddK", res, err, (unsigned long long)neval)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_tanhsinh(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    double epsabs;
+    double epsrel = 0.;
+    unsigned int maxlevel = 8;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOd|dIn", &ob_f, &ob_intervals, &epsabs, &epsrel, &maxlevel, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    if (!f || !intervals) {
+        free_function(f);
+        return NULL;
+    }
+
+    double res, err;
+    uint64_t neval;
+    PyObject *value = (
+        tanhsinh(f, intervals, d, epsabs, epsrel, maxlevel, &res, &err, &neval)
+        ? NULL : Py_BuildValue("ddK", res, err, (unsigned long long)neval)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals);
+
+    return value;
+
+}
+
+static PyObject *integral_separable(PyObject *self, PyObject *args) {
+
+    PyObject *ob_fs;
+    PyObject *ob_intervals;
+    PyObject *ob_rrules = Py_None;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(args, "OO|On", &ob_fs, &ob_intervals, &ob_rrules, &blocksize)) { return NULL; }
+
+    unsigned int d;
+    struct Interval **intervals = parse_intervals(ob_intervals, &d);
+    if (!intervals) { return NULL; }
+
+    struct Grid *grid = parse_grid(intervals, d, ob_rrules);
+    PyObject *value = grid ? separable_value(ob_fs, grid, blocksize) : NULL;
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free(intervals); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_rule(PyObject *self, PyObject *args) {
+
+    int rule;
+    unsigned int n;
+    if (!PyArg_ParseTuple(args, "iI", &rule, &n)) { return NULL; }
+
+    if (rule < GAUSS_LEGENDRE || rule > GAUSS_PATTERSON || !n
+        || rule_size((enum QuadratureRules)rule, n) != n) {
+        PyErr_SetString(PyExc_ValueError, "Expected a Gauss or Clenshaw-Curtis rule and a valid node count");
+        return NULL;
+    }
+
+    double *x = (double *)calloc(n, sizeof(double));
+    double *w = (double *)calloc(n, sizeof(double));
+    PyObject *nodes = PyTuple_New(n);
+    PyObject *weights = PyTuple_New(n);
+    if (!x || !w || !nodes || !weights) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(x); free(w); Py_XDECREF(nodes); Py_XDECREF(weights);
+        return NULL;
+    }
+
+    rule_nodes((enum QuadratureRules)rule, n, x, w);
+    for (unsigned int j = 0; j < n; ++j) {
+        PyObject *xj = PyFloat_FromDouble(*(x + j));
+        PyObject *wj = PyFloat_FromDouble(*(w + j));
+        if (!xj || !wj) {
+            free(x); free(w); Py_XDECREF(xj); Py_XDECREF(wj); Py_DECREF(nodes); Py_DECREF(weights);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(nodes, j, xj);
+        PyTuple_SET_ITEM(weights, j, wj);
+    }
+    free(x); free(w);
+
+    return Py_BuildValue("NN", nodes, weights);
+
+}
+
+static PyObject *integral_get_rule_cache(PyObject *self, PyObject *args) {
+
+    const char *path = get_rule_cache();
+    if (!path) { Py_RETURN_NONE; }
+
+    return PyUnicode_DecodeFSDefault(path);
+
+}
+
+static PyObject *integral_set_rule_cache(PyObject *self, PyObject *args) {
+
+    PyObject *ob_path;
+    if (!PyArg_ParseTuple(args, "O", &ob_path)) { return NULL; }
+
+    if (ob_path == Py_None) {
+        set_rule_cache(NULL);
+        Py_RETURN_NONE;
+    }
+
+    PyObject *bytes;
+    if (!PyUnicode_FSConverter(ob_path, &bytes)) { return NULL; }
+    short status = set_rule_cache(PyBytes_AS_STRING(bytes));
+    Py_DECREF(bytes);
+    if (status == -1) { return NULL; }
+
+    Py_RETURN_NONE;
+
+}
+
+static PyObject *integral_trapz(
+    PyObject *self, PyObject *args
+) { return integrate_samples(args, SAMPLE_TRAPEZOID); }
+
+static PyObject *integral_simpson(
+    PyObject *self, PyObject *args
+) { return integrate_samples(args, SAMPLE_SIMPSON); }
+
+static PyObject *integral_romb(
+    PyObject *self, PyObject *args
+) { return integrate_samples(args, SAMPLE_ROMBERG); }
+
+static PyObject *integral_cumtrapz(PyObject *self, PyObject *args) {
+
+    PyObject *ob_y;
+    PyObject *ob_x = Py_None;
+    PyObject *ob_axis = NULL;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "O|OOI", &ob_y, &ob_x, &ob_axis, &nthreads)) { return NULL; }
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(ob_y, &view, PyBUF_RECORDS_RO)) { return NULL; }
+    const char *format = view.format ? view.format : "B";
+    if (*format == '<' || *format == '=' || *format == '@') { ++format; }
+    if (strcmp(format, "d") || view.ndim < 1) {
+        PyErr_SetString(PyExc_TypeError, "Expected a buffer of 'float' samples with at least one dimension");
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    int naxes = 1, axes[PyBUF_MAX_NDIM] = { view.ndim - 1 };
+    short chosen[PyBUF_MAX_NDIM] = { 0 };
+    double dx[PyBUF_MAX_NDIM], *x[PyBUF_MAX_NDIM] = { NULL };
+    short status = ob_axis ? parse_axes(ob_axis, view.ndim, axes, &naxes) : 0;
+
+    const short per_axis = naxes > 1 && PyTuple_Check(ob_x) && PyTuple_GET_SIZE(ob_x) == naxes;
+    for (int i = 0; !status && i < naxes; ++i) {
+        const int axis = *(axes + i);
+        PyObject *ob_spacing = per_axis ? PyTuple_GET_ITEM(ob_x, i) : ob_x;
+        status = parse_coordinates(ob_spacing, *(view.shape + axis), dx + axis, x + axis);
+        chosen[axis] = 1;
+    }
+
+    PyObject *value = (
+        status ? NULL : cumulate_samples(&view, chosen, dx, x, nthreads ? nthreads : get_threads())
+    );
+
+    for (int j = 0; j < view.ndim; ++j) { free(x[j]); }
+    PyBuffer_Release(&view);
+
+    return value;
+
+}
+
+static PyObject *integral_cumulative(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    PyObject *ob_rrules = Py_None;
+    PyObject *ob_axis = Py_None;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(
+        args, "OO|OOnI", &ob_f, &ob_intervals, &ob_rrules, &ob_axis, &blocksize, &nthreads
+    )) { return NULL; }
+
+    if (ob_rrules != Py_None && PySequence_Check(ob_intervals) && PySequence_Check(ob_rrules)
+        && PySequence_Size(ob_intervals) != PySequence_Size(ob_rrules)) {
+        PyErr_SetString(PyExc_ValueError, "Expected one Riemann rule per interval");
+        return NULL;
+    }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    enum RiemannRules *rrules = intervals && ob_rrules != Py_None ? parse_rrules(ob_rrules) : NULL;
+    if (!f || !intervals || (ob_rrules != Py_None && !rrules)) {
+        if (intervals) { for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); } }
+        free_function(f); free(intervals);
+        return NULL;
+    }
+
+    int naxes, axes[PyBUF_MAX_NDIM];
+    short chosen[PyBUF_MAX_NDIM] = { 0 };
+    Py_ssize_t size = 1, shape[PyBUF_MAX_NDIM];
+    PyObject *value = NULL, *bytes = NULL;
+    struct Grid *grid = NULL;
+    if (d >= PyBUF_MAX_NDIM) {
+        PyErr_Format(PyExc_ValueError, "Expected fewer than %d intervals", PyBUF_MAX_NDIM);
+    } else if (
+        !parse_axes(ob_axis, (int)d, axes, &naxes)
+        && (grid = rrules ? riemann_grid(intervals, rrules, d) : trapezoidal_grid(intervals, d))
+        && !probe_grid(f, grid)
+    ) {
+        for (int i = 0; i < naxes; ++i) { chosen[*(axes + i)] = 1; }
+        for (unsigned int i = 0; i < d; ++i) {
+            shape[i] = (Py_ssize_t)(*(intervals + i))->n + (!rrules || chosen[i]);
+            size *= shape[i];
+        }
+        shape[d] = f->outputs;
+        bytes = PyByteArray_FromStringAndSize(NULL, size * shape[d] * (Py_ssize_t)sizeof(double));
+    }
+
+    double *res = bytes ? (double *)PyByteArray_AS_STRING(bytes) : NULL;
+    if (bytes && cumulative(f, grid, intervals, rrules, chosen, nthreads ? nthreads : get_threads(), res)) {
+        Py_CLEAR(bytes);
+    }
+    if (bytes) { value = shaped_view(bytes, (int)d + (f->outputs > 1), shape); }
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals); free(rrules); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_sweep(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    PyObject *ob_params;
+    PyObject *ob_rrules = Py_None;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(
+        args, "OOO|OnI", &ob_f, &ob_intervals, &ob_params, &ob_rrules, &blocksize, &nthreads
+    )) { return NULL; }
+
+    unsigned int d;
+    struct Interval **intervals = parse_intervals(ob_intervals, &d);
+    if (!intervals) { return NULL; }
+
+    struct Grid *grid = parse_grid(intervals, d, ob_rrules);
+    const unsigned int threads = nthreads ? nthreads : get_threads();
+    PyObject *value = grid ? sweep_value(ob_f, grid, ob_params, blocksize, threads) : NULL;
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free(intervals); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_progressive(PyObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_intervals;
+    PyObject *ob_rrules = Py_None;
+    double timeout = 0.;
+    unsigned long long maxeval = 0;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(
+        args, "OO|OdKn", &ob_f, &ob_intervals, &ob_rrules, &timeout, &maxeval, &blocksize
+    )) { return NULL; }
+
+    unsigned int d = 0;
+    struct Function *f = parse_function(ob_f, blocksize);
+    struct Interval **intervals = f ? parse_intervals(ob_intervals, &d) : NULL;
+    struct Grid *grid = intervals ? parse_grid(intervals, d, ob_rrules) : NULL;
+    if (!grid) {
+        if (intervals) { for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); } }
+        free_function(f); free(intervals);
+        return NULL;
+    }
+
+    double res, fraction;
+    PyObject *value = (
+        progressive(f, grid, timeout, (uint64_t)maxeval, &res, &fraction)
+        ? NULL : Py_BuildValue("dd", res, fraction)
+    );
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free_function(f); free(intervals); free_grid(grid);
+
+    return value;
+
+}
+
+static PyObject *integral_get_threads(
+    PyObject *self, PyObject *args
+) { return PyLong_FromUnsignedLong(get_threads()); }
+
+static PyObject *integral_set_threads(PyObject *self, PyObject *args) {
+
+    unsigned int nthreads;
+    if (!PyArg_ParseTuple(args, "I", &nthreads)) { return NULL; }
+    if (set_threads(nthreads) == -1) { return NULL; }
+
+    Py_RETURN_NONE;
+
+}
+
+/**
+ * Initializes an interval from its bounds and number of subintervals. Bounds may be infinite, for use
+ * with `tanhsinh`, but not NaN.
+ */
+static int Interval_init(IntervalObject *self, PyObject *args, PyObject *kwds) {
+
+    double lower, upper;
+    unsigned int n = 1;
+    if (!PyArg_ParseTuple(args, "dd|I", &lower, &upper, &n)) { return -1; }
+    if (isnan(lower) || isnan(upper)) {
+        PyErr_SetString(PyExc_ValueError, "Expected interval bounds that are not NaN");
+        return -1;
+    }
+
+    self->lower = lower, self->upper = upper, self->n = n;
+
+    return 0;
+
+}
+
+static void Plan_dealloc(PlanObject *self) {
+
+    free_grid(self->grid);
+    Py_TYPE(self)->tp_free((PyObject *)self);
+
+}
+
+/**
+ * Initializes a plan from a sequence of 'Interval' objects and, for a Riemann sum, a sequence of
+ * Riemann rules, one per interval. Without rules, the plan applies the trapezoidal rule.
+ */
+static int Plan_init(PlanObject *self, PyObject *args, PyObject *kwds) {
+
+    PyObject *ob_intervals;
+    PyObject *ob_rrules = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O", &ob_intervals, &ob_rrules)) { return -1; }
+
+    unsigned int d;
+    struct Interval **intervals = parse_intervals(ob_intervals, &d);
+    if (!intervals) { return -1; }
+
+    struct Grid *grid = parse_grid(intervals, d, ob_rrules);
+
+    for (unsigned int i = 0; i < d; ++i) { free(*(intervals + i)); }
+    free(intervals);
+    if (!grid) { return -1; }
+
+    free_grid(self->grid);
+    self->grid = grid;
+
+    return 0;
+
+}
+
+/**
+ * Integrates a mathematical function of several real variables over the grid of a plan.
+ */
+static PyObject *Plan_integrate(PlanObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "O|nI", &ob_f, &blocksize, &nthreads)) { return NULL; }
+    if (!self->grid) {
+        PyErr_SetString(PyExc_RuntimeError, "Plan is not initialized");
+        return NULL;
+    }
+
+    struct Function *f = parse_function(ob_f, blocksize);
+    if (!f) { return NULL; }
+
+    PyObject *value = grid_value(self->grid, f, nthreads ? nthreads : get_threads());
+    free_function(f);
+
+    return value;
+
+}
+
+/**
+ * Integrates each of a sequence of mathematical functions of several real variables over the grid of
+ * a plan, returning a 'tuple' of the integrals.
+ */
+static PyObject *Plan_integrate_many(PlanObject *self, PyObject *args) {
+
+    PyObject *ob_fs;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "O|nI", &ob_fs, &blocksize, &nthreads)) { return NULL; }
+    if (!self->grid) {
+        PyErr_SetString(PyExc_RuntimeError, "Plan is not initialized");
+        return NULL;
+    }
+
+    PyObject *fs = PySequence_Fast(ob_fs, "Expected a sequence of functions");
+    if (!fs) { return NULL; }
+
+    Py_ssize_t size = PySequence_Fast_GET_SIZE(fs);
+    PyObject *tuple = PyTuple_New(size);
+    if (!tuple) {
+        Py_DECREF(fs);
+        return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < size; ++i) {
+
+        struct Function *f = parse_function(PySequence_Fast_GET_ITEM(fs, i), blocksize);
+        if (!f) {
+            Py_DECREF(fs); Py_DECREF(tuple);
+            return NULL;
+        }
+
+        PyObject *value = grid_value(self->grid, f, nthreads ? nthreads : get_threads());
+        free_function(f);
+
+        if (!value) {
+            Py_DECREF(fs); Py_DECREF(tuple);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(tuple, i, value);
+
+    }
+    Py_DECREF(fs);
+
+    return tuple;
+
+}
+
+/**
+ * Integrates a separable integrand, given as in `integral.separable`, over the grid of a plan.
+ */
+static PyObject *Plan_separable(PlanObject *self, PyObject *args) {
+
+    PyObject *ob_fs;
+    Py_ssize_t blocksize = 0;
+    if (!PyArg_ParseTuple(args, "O|n", &ob_fs, &blocksize)) { return NULL; }
+    if (!self->grid) {
+        PyErr_SetString(PyExc_RuntimeError, "Plan is not initialized");
+        return NULL;
+    }
+
+    return separable_value(ob_fs, self->grid, blocksize);
+
+}
+
+/**
+ * Integrates a family of functions, given as in `integral.sweep`, over the grid of a plan for each of
+ * a sequence of parameters.
+ */
+static PyObject *Plan_sweep(PlanObject *self, PyObject *args) {
+
+    PyObject *ob_f;
+    PyObject *ob_params;
+    Py_ssize_t blocksize = 0;
+    unsigned int nthreads = 0;
+    if (!PyArg_ParseTuple(args, "OO|nI", &ob_f, &ob_params, &blocksize, &nthreads)) { return NULL; }
+    if (!self->grid) {
+        PyErr_SetString(PyExc_RuntimeError, "Plan is not initialized");
+        return NULL;
+    }
+
+    return sweep_value(ob_f, self->grid, ob_params, blocksize, nthreads ? nthreads : get_threads());
 
 }
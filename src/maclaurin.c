@@ -2,8 +2,9 @@
  * Source file for "../include/maclaurin.h"
  */
 
+#include <math.h>
+
 #include "../include/maclaurin.h"
-#include "../include/numbers.h"
 
 
 static double exponential_(
@@ -21,14 +22,14 @@ double exponential(double x) {
 
 static double ln_(double x, unsigned int n, double term) {
 
-    if (!(-1 < x <= 1)) { return DNAN; }
+    if (!(-1 < x <= 1)) { return NAN; }
     return (n == 1 ? x : -x * (n - 1) / n * term);
 
 }
 
 double ln(double x) {
 
-    if (x <= 0.) { return DNAN; }
+    if (x <= 0.) { return NAN; }
     unsigned int n = 1;
     double term, res = 0.;
     while ((term = ln_((x <= 2 ? x - 1 : (1 - x) / x), n++, term)) != 0) { res += term; }
@@ -38,14 +39,14 @@ double ln(double x) {
 
 static double geometric_(double x, unsigned int alpha, unsigned int n, double term) {
 
-    if (!(-1 < x < 1)) { return DNAN; }
+    if (!(-1 < x < 1)) { return NAN; }
     return (n == (alpha - 1) ? alpha - 1 : x * n / (n - alpha + 1) * term);
 
 }
 
 double geometric(double x, unsigned int alpha) {
 
-    if (x == 0.) { return DNAN; }
+    if (x == 0.) { return NAN; }
     unsigned int n = alpha - 1;
     double term, res = 0.;
     while ((term = geometric_(x + 1, alpha, n++, term)) != 0) { res += term; }
@@ -55,7 +56,7 @@ double geometric(double x, unsigned int alpha) {
 
 static double binomial_(double x, unsigned int alpha, unsigned int n, double term) {
 
-    if (!(-1 < x < 1)) { return DNAN; }
+    if (!(-1 < x < 1)) { return NAN; }
     return (n == 0 ? alpha * x : x * (alpha - n + 1) / n * term);
 
 }
@@ -73,14 +74,14 @@ static double root_(
     double x, unsigned int n, unsigned int alpha, double term
 ) {
 
-    if (!(-1 < x < 1)) { return DNAN; }
+    if (!(-1 < x < 1)) { return NAN; }
     return (n == 0 ? 1 : x * (1 - (n - 1) * alpha) / (n * alpha) * term);
 
 }
 
 double root(double x, unsigned int alpha) {
 
-    if (x < 0.) { return DNAN; }
+    if (x < 0.) { return NAN; }
     unsigned int n = 0;
     double term, res = 0.;
     while ((term = root_(x - 1, alpha, n++, term)) != 0) { res += term; }
@@ -92,7 +93,7 @@ static double invroot_(
     double x, unsigned int n, unsigned int alpha, double term
 ) {
 
-    if (!(-1 < x < 1)) { return DNAN; }
+    if (!(-1 < x < 1)) { return NAN; }
     return (n == 0 ? 1 : x * (-1 - (n - 1) * alpha) / (n * alpha) * term);
 
 }
@@ -108,7 +109,7 @@ double invroot(double x, unsigned int alpha) {
 
 static double sine_(
     double x, unsigned int n, double term
-) { return (n == 0 ? x : -power(x, 2) / ((2 * n) * (2 * n + 1)) * term); }
+) { return (n == 0 ? x : -pow(x, 2) / ((2 * n) * (2 * n + 1)) * term); }
 
 double sine(double x) {
 
@@ -121,7 +122,7 @@ double sine(double x) {
 
 static double cosine_(
     double x, unsigned int n, double term
-) { return (n == 0 ? 1 : -power(x, 2) / ((2 * n) * (2 * n - 1)) * term); }
+) { return (n == 0 ? 1 : -pow(x, 2) / ((2 * n) * (2 * n - 1)) * term); }
 
 double cosine(double x) {
 
@@ -139,10 +140,10 @@ double cotangent(double x) { return sine(x) / cosine(x); }
 
 static double arcsine_(double x, unsigned int n, double term) {
 
-    if (!(-1 <= x <= 1)) { return DNAN; }
+    if (!(-1 <= x <= 1)) { return NAN; }
     return (
-        n == 0 ? x : power(x, 2) * (
-            ((2 * n) * ipower(2 * n - 1, 2)) / (4 * ipower(n, 2) * (2 * n + 1))
+        n == 0 ? x : pow(x, 2) * (
+            ((2 * n) * pow(2 * n - 1, 2)) / (4 * pow(n, 2) * (2 * n + 1))
         ) * term
     );
 
@@ -150,7 +151,7 @@ static double arcsine_(double x, unsigned int n, double term) {
 
 double arcsine(double x) {
 
-    if (!(-1 <= x <= 1)) { return DNAN; }
+    if (!(-1 <= x <= 1)) { return NAN; }
 
     unsigned int n = 0;
     double term, res = 0.;
@@ -163,8 +164,8 @@ double arccosine(double x) { return arcsine(1) - arcsine(x); }
 
 static double arctangent_(double x, unsigned int n, double term) {
 
-    if (!(-1 <= x <= 1)) { return DNAN; }
-    return (n == 0 ? x : -power(x, 2) * (2 * n - 1) / (2 * n + 1) * term);
+    if (!(-1 <= x <= 1)) { return NAN; }
+    return (n == 0 ? x : -pow(x, 2) * (2 * n - 1) / (2 * n + 1) * term);
 
 }
 
@@ -182,7 +183,7 @@ double arccotangent(double x) { return arctangent(1 / x); }
 
 static double sineh_(
     double x, unsigned int n, double term
-) { return (n == 0 ? x: power(x, 2) / ((2 * n) * (2 * n + 1)) * term); }
+) { return (n == 0 ? x: pow(x, 2) / ((2 * n) * (2 * n + 1)) * term); }
 
 double sineh(double x) {
 
@@ -195,7 +196,7 @@ double sineh(double x) {
 
 static double cosineh_(
     double x, unsigned int n, double term
-) { return (n == 0 ? 1 : power(x, 2) / ((2 * n) * (2 * n - 1)) * term); }
+) { return (n == 0 ? 1 : pow(x, 2) / ((2 * n) * (2 * n - 1)) * term); }
 
 double cosineh(double x) {
 
@@ -213,10 +214,10 @@ double cotangenth(double x) { return cosineh(x) / sineh(x); }
 
 static double arcsineh_(double x, unsigned int n, double term) {
 
-    if (!(-1 <= x <= 1)) { return DNAN; }
+    if (!(-1 <= x <= 1)) { return NAN; }
     return (
-        n == 0 ? x : -power(x, 2) * (
-            (2 * n) * ipower(2 * n - 1, 2)) / (4 * ipower(n, 2) * (2 * n + 1)
+        n == 0 ? x : -pow(x, 2) * (
+            (2 * n) * pow(2 * n - 1, 2)) / (4 * pow(n, 2) * (2 * n + 1)
         ) * term
     );
 
@@ -224,7 +225,7 @@ static double arcsineh_(double x, unsigned int n, double term) {
 
 double arcsineh(double x) {
 
-    if (!(-1 <= x <= 1)) { return DNAN; }
+    if (!(-1 <= x <= 1)) { return NAN; }
     unsigned int n = 0;
     double term, res = 0.;
     while ((term = arcsineh_(x, n++, term)) != 0) { res += term; }
@@ -234,15 +235,15 @@ double arcsineh(double x) {
 
 double arccosineh(double x) {
 
-    double res = arcsinh(root(power(x, 2), 2) - 1);
+    double res = arcsineh(root(pow(x, 2), 2) - 1);
     return (res >= 0. ? res : -res);
 
 }
 
 static double arctangenth_(double x, unsigned int n, double term) {
 
-    if (!(-1 < x < 1)) { return DNAN; }
-    return (n == 0 ? x : power(x, 2) * (2 * n - 1) / (2 * n + 1) * term);
+    if (!(-1 < x < 1)) { return NAN; }
+    return (n == 0 ? x : pow(x, 2) * (2 * n - 1) / (2 * n + 1) * term);
 
 }
 
@@ -256,7 +257,7 @@ double arctangenth(double x) {
 }
 
 double arcsecanth(double x) { return arccosineh(1 / x); }
-double arccosecanth(double x) { return arccsecanth(1 / x); }
+double arccosecanth(double x) { return arcsineh(1 / x); }
 double arccotangenth(double x) { return arctangenth(1 / x); }
 
 static PyObject *maclaurin_(double (*func)(double), PyObject *args) {
@@ -0,0 +1,225 @@
+/**
+ * Source file for "../include/parallel.h"
+ */
+
+#include <stdint.h>
+
+#include "../include/parallel.h"
+
+
+/**
+ * A range of chunk indices owned by a worker. The owner pops chunks from the front of the range, and
+ * idle workers steal half of the remaining chunks from the back.
+ */
+struct Deque {
+    PyThread_type_lock lock;
+    size_t lo;
+    size_t hi;
+};
+
+static struct {
+    short initialized;
+    unsigned int nworkers;
+    PyThread_type_lock busy;
+    PyThread_type_lock mutex;
+    PyThread_type_lock done;
+    PyThread_type_lock wake[MAX_THREADS];
+    struct Deque deques[MAX_THREADS];
+    unsigned int active;
+    unsigned int pending;
+    Task task;
+    void *context;
+} pool;
+
+static unsigned int default_threads = 1;
+
+/**
+ * Returns the default number of threads used by parallel computations.
+ */
+unsigned int get_threads(void) { return default_threads; }
+
+/**
+ * Sets the default number of threads used by parallel computations.
+ *
+ * @param nthreads The number of threads, between `1` and `MAX_THREADS`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short set_threads(unsigned int nthreads) {
+
+    if (nthreads < 1 || nthreads > MAX_THREADS) {
+        PyErr_Format(PyExc_ValueError, "Expected a number of threads between 1 and %d", MAX_THREADS);
+        return -1;
+    }
+    default_threads = nthreads;
+
+    return 0;
+
+}
+
+/**
+ * Pops the next chunk from the front of the deque of a worker.
+ */
+static short pop(unsigned int worker, size_t *chunk) {
+
+    struct Deque *deque = pool.deques + worker;
+    short found = 0;
+
+    PyThread_acquire_lock(deque->lock, WAIT_LOCK);
+    if (deque->lo < deque->hi) {
+        *chunk = deque->lo++;
+        found = 1;
+    }
+    PyThread_release_lock(deque->lock);
+
+    return found;
+
+}
+
+/**
+ * Steals half of the remaining chunks of another worker, keeping the first stolen chunk and moving the
+ * rest into the deque of the thief.
+ */
+static short steal(unsigned int worker, size_t *chunk) {
+
+    for (unsigned int k = 1; k < pool.active; ++k) {
+
+        struct Deque *victim = pool.deques + (worker + k) % pool.active;
+        size_t lo, hi;
+
+        PyThread_acquire_lock(victim->lock, WAIT_LOCK);
+        hi = victim->hi;
+        lo = hi - (hi - victim->lo + 1) / 2;
+        if (lo < hi) { victim->hi = lo; }
+        PyThread_release_lock(victim->lock);
+        if (lo >= hi) { continue; }
+
+        struct Deque *own = pool.deques + worker;
+        PyThread_acquire_lock(own->lock, WAIT_LOCK);
+        own->lo = lo + 1, own->hi = hi;
+        PyThread_release_lock(own->lock);
+
+        *chunk = lo;
+        return 1;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Runs chunks of the current task until no worker has any left.
+ */
+static void run(unsigned int worker) {
+
+    size_t chunk;
+    while (pop(worker, &chunk) || steal(worker, &chunk)) { pool.task(pool.context, worker, chunk); }
+
+}
+
+/**
+ * Entry point of a helper thread. Helpers sleep on their wake lock between tasks.
+ */
+static void work(void *arg) {
+
+    const unsigned int worker = (unsigned int)(uintptr_t)arg;
+
+    for (;;) {
+
+        PyThread_acquire_lock(pool.wake[worker], WAIT_LOCK);
+        run(worker);
+
+        PyThread_acquire_lock(pool.mutex, WAIT_LOCK);
+        if (--pool.pending == 0) { PyThread_release_lock(pool.done); }
+        PyThread_release_lock(pool.mutex);
+
+    }
+
+}
+
+/**
+ * Starts helper threads until the pool can run `nthreads` workers, counting the calling thread.
+ */
+static short grow(unsigned int nthreads) {
+
+    if (!pool.initialized) {
+        if (
+            !(pool.busy = PyThread_allocate_lock())
+            || !(pool.mutex = PyThread_allocate_lock())
+            || !(pool.done = PyThread_allocate_lock())
+            || !(pool.deques->lock = PyThread_allocate_lock())
+        ) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate lock");
+            return -1;
+        }
+        PyThread_acquire_lock(pool.done, WAIT_LOCK);
+        pool.nworkers = 1;
+        pool.initialized = 1;
+    }
+
+    while (pool.nworkers < nthreads) {
+
+        const unsigned int worker = pool.nworkers;
+        if (
+            !(pool.wake[worker] = PyThread_allocate_lock())
+            || !(pool.deques[worker].lock = PyThread_allocate_lock())
+        ) {
+            PyErr_SetString(PyExc_MemoryError, "Failed to allocate lock");
+            return -1;
+        }
+        PyThread_acquire_lock(pool.wake[worker], WAIT_LOCK);
+
+        if (PyThread_start_new_thread(work, (void *)(uintptr_t)worker) == PYTHREAD_INVALID_THREAD_ID) {
+            PyErr_SetString(PyExc_RuntimeError, "Failed to start thread");
+            return -1;
+        }
+        ++pool.nworkers;
+
+    }
+
+    return 0;
+
+}
+
+/**
+ * Runs a task over chunks `0, 1, ..., nchunks - 1` on a work-stealing pool of threads.
+ *
+ * Chunks are initially split into contiguous ranges, one per worker; workers that run out of chunks
+ * steal half of the remaining range of another worker. The task must not use the Python API, as it
+ * runs with the GIL released. The caller must hold the GIL.
+ *
+ * @param nthreads The number of threads to use, including the calling thread
+ * @param nchunks The number of chunks
+ * @param task The task to run for each chunk
+ * @param context The context with which to call `task`
+ * @return `0` upon success, or `-1` upon failure
+ */
+short parallel_for(unsigned int nthreads, size_t nchunks, Task task, void *context) {
+
+    if (nthreads < 1 || nthreads > MAX_THREADS) {
+        PyErr_Format(PyExc_ValueError, "Expected a number of threads between 1 and %d", MAX_THREADS);
+        return -1;
+    }
+    if (nthreads > nchunks) { nthreads = nchunks ? (unsigned int)nchunks : 1; }
+    if (grow(nthreads) == -1) { return -1; }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(pool.busy, WAIT_LOCK);
+
+    pool.task = task, pool.context = context;
+    pool.active = nthreads, pool.pending = nthreads - 1;
+    for (unsigned int i = 0; i < nthreads; ++i) {
+        pool.deques[i].lo = nchunks * i / nthreads;
+        pool.deques[i].hi = nchunks * (i + 1) / nthreads;
+    }
+
+    for (unsigned int i = 1; i < nthreads; ++i) { PyThread_release_lock(pool.wake[i]); }
+    run(0);
+    if (nthreads > 1) { PyThread_acquire_lock(pool.done, WAIT_LOCK); }
+
+    PyThread_release_lock(pool.busy);
+    Py_END_ALLOW_THREADS
+
+    return 0;
+
+}
@@ -0,0 +1,122 @@
+/**
+ * Source file for "../include/reduction.h"
+ *
+ * Values are summed in leaves of `LEAF_SIZE` consecutive values, each reduced over `LANES` strided
+ * Kahan-Neumaier accumulators and a fixed pairwise tree. Leaves are then combined by a pairwise tree
+ * maintained as a binary counter, with one node per level. The shape of both trees depends only on the
+ * number of values, so the result is bit-identical however the values are split into consecutive
+ * chunks, as long as each chunk but the last spans a power-of-two number of leaves.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "../include/reduction.h"
+
+
+/**
+ * Sums two compensated values, carrying the rounding error of the sum into the compensation.
+ */
+static struct Compensated combine(struct Compensated a, struct Compensated b) {
+
+    double t = a.sum + b.sum;
+    double e = fabs(a.sum) >= fabs(b.sum) ? (a.sum - t) + b.sum : (b.sum - t) + a.sum;
+
+    return (struct Compensated){ t, a.c + b.c + e };
+
+}
+
+/**
+ * Sums up to `LEAF_SIZE` values into a compensated value.
+ */
+static struct Compensated reduce_leaf(const double *v, unsigned int n) {
+
+    double s[LANES] = { 0. }, c[LANES] = { 0. };
+
+    unsigned int i = 0;
+    for (; i + LANES <= n; i += LANES) {
+        for (unsigned int j = 0; j < LANES; ++j) {
+            double t = s[j] + *(v + i + j);
+            c[j] += fabs(s[j]) >= fabs(*(v + i + j)) ? (s[j] - t) + *(v + i + j) : (*(v + i + j) - t) + s[j];
+            s[j] = t;
+        }
+    }
+    for (unsigned int j = 0; i < n; ++i, ++j) {
+        double t = s[j] + *(v + i);
+        c[j] += fabs(s[j]) >= fabs(*(v + i)) ? (s[j] - t) + *(v + i) : (*(v + i) - t) + s[j];
+        s[j] = t;
+    }
+
+    struct Compensated lanes[LANES];
+    for (unsigned int j = 0; j < LANES; ++j) { lanes[j] = (struct Compensated){ s[j], c[j] }; }
+    for (unsigned int width = LANES / 2; width > 0; width /= 2) {
+        for (unsigned int j = 0; j < width; ++j) { lanes[j] = combine(lanes[2 * j], lanes[2 * j + 1]); }
+    }
+
+    return lanes[0];
+
+}
+
+/**
+ * Adds a node spanning `2^level` leaves after all the leaves already in the tree.
+ */
+static void push(struct Reducer *r, struct Compensated node, unsigned int level) {
+
+    const uint64_t span = (uint64_t)1 << level;
+
+    for (; r->nleaves >> level & 1; ++level) { node = combine(*(r->nodes + level), node); }
+    *(r->nodes + level) = node;
+    r->nleaves += span;
+
+}
+
+/**
+ * Initializes an empty reducer.
+ */
+void reducer_init(struct Reducer *r) {
+
+    r->count = 0;
+    r->nleaves = 0;
+
+}
+
+/**
+ * Adds a value after all the values already in a reducer.
+ */
+void reducer_add(struct Reducer *r, double value) {
+
+    *(r->leaf + r->count++) = value;
+    if (r->count == LEAF_SIZE) {
+        push(r, reduce_leaf(r->leaf, LEAF_SIZE), 0);
+        r->count = 0;
+    }
+
+}
+
+/**
+ * Appends the values of reducer `s` after the values of reducer `r`. The values in `r` must span a
+ * whole number of leaves, and a multiple of the largest power-of-two number of leaves spanned by `s`.
+ */
+void reducer_merge(struct Reducer *r, const struct Reducer *s) {
+
+    for (int level = MAX_LEVELS - 1; level >= 0; --level) {
+        if (s->nleaves >> level & 1) { push(r, *(s->nodes + level), level); }
+    }
+    memcpy(r->leaf, s->leaf, s->count * sizeof(double));
+    r->count = s->count;
+
+}
+
+/**
+ * Computes the sum of the values in a reducer.
+ */
+double reducer_result(const struct Reducer *r) {
+
+    struct Compensated acc = reduce_leaf(r->leaf, r->count);
+    for (unsigned int level = 0; level < MAX_LEVELS; ++level) {
+        if (r->nleaves >> level & 1) { acc = combine(*(r->nodes + level), acc); }
+    }
+
+    return acc.sum + acc.c;
+
+}
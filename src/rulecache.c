@@ -0,0 +1,235 @@
+/**
+ * Source file for "../include/rulecache.h"
+ *
+ * Each rule is stored in its own file, named after its family, number of nodes and parameters, as a
+ * `struct RuleHeader` followed by the nodes and the weights. Files are read whole into the caller's
+ * arrays, and are written to a temporary file renamed into place, so that any number of processes can
+ * share the cache directory and readers never observe a partial rule. A file that is missing,
+ * truncated or written by another version of the format is rebuilt.
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../include/rulecache.h"
+
+
+static struct {
+    short initialized;
+    short enabled;
+    char path[4096];
+} cache;
+
+/**
+ * Sets the default cache directory from the `RULE_CACHE_ENV` environment variable, or from the user
+ * cache directory. An empty environment variable disables the cache.
+ */
+static void init_cache(void) {
+
+    if (cache.initialized) { return; }
+    cache.initialized = 1;
+
+    const char *env = getenv(RULE_CACHE_ENV);
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    int len = -1;
+    if (env) {
+        len = snprintf(cache.path, sizeof(cache.path), "%s", env);
+    } else if (xdg && *xdg) {
+        len = snprintf(cache.path, sizeof(cache.path), "%s/pync/rules", xdg);
+    } else if (home && *home) {
+        len = snprintf(cache.path, sizeof(cache.path), "%s/.cache/pync/rules", home);
+    }
+    cache.enabled = len > 0 && (size_t)len < sizeof(cache.path);
+
+}
+
+/**
+ * Returns the directory of the rule cache, or `NULL` if the cache is disabled.
+ */
+const char *get_rule_cache(void) {
+
+    init_cache();
+
+    return cache.enabled ? cache.path : NULL;
+
+}
+
+/**
+ * Sets the directory of the rule cache, or disables the cache if `path` is `NULL`.
+ *
+ * @return `0` upon success, or `-1` upon failure
+ */
+short set_rule_cache(const char *path) {
+
+    init_cache();
+    if (!path) {
+        cache.enabled = 0;
+        return 0;
+    }
+    if (!*path || strlen(path) >= sizeof(cache.path)) {
+        PyErr_SetString(PyExc_ValueError, "Expected a non-empty path of reasonable length");
+        return -1;
+    }
+    strcpy(cache.path, path);
+    cache.enabled = 1;
+
+    return 0;
+
+}
+
+#ifndef _WIN32
+
+/**
+ * Writes the header identifying a rule.
+ */
+static void fill_header(
+    struct RuleHeader *header, unsigned int family, unsigned int n, const double *params
+) {
+
+    memset(header, 0, sizeof(struct RuleHeader));
+    memcpy(header->magic, RULE_CACHE_MAGIC, sizeof(header->magic));
+    header->version = RULE_CACHE_VERSION;
+    header->family = family, header->n = n;
+    if (params) { memcpy(header->params, params, sizeof(header->params)); }
+
+}
+
+/**
+ * Writes the path of the file holding a rule, returning `0` upon success or `-1` if it is too long.
+ */
+static short rule_path(char *path, size_t size, const struct RuleHeader *header) {
+
+    uint64_t bits[RULE_CACHE_PARAMS];
+    memcpy(bits, header->params, sizeof(bits));
+    int len = snprintf(
+        path, size, "%s/v%u-%u-%u-%016llx%016llx.rule", cache.path, header->version, header->family,
+        header->n, (unsigned long long)bits[0], (unsigned long long)bits[1]
+    );
+
+    return len > 0 && (size_t)len < size ? 0 : -1;
+
+}
+
+/**
+ * Reads the nodes and weights of a rule from its file, returning `0` upon success or `-1` if the file
+ * is missing or does not hold the expected rule.
+ */
+static short read_rule(const char *path, const struct RuleHeader *header, double *x, double *w) {
+
+    const size_t n = header->n;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { return -1; }
+
+    struct stat st;
+    struct RuleHeader stored;
+    const short ok = (
+        !fstat(fd, &st) && (size_t)st.st_size == sizeof(struct RuleHeader) + 2 * n * sizeof(double)
+        && read(fd, &stored, sizeof(struct RuleHeader)) == (ssize_t)sizeof(struct RuleHeader)
+        && !memcmp(&stored, header, sizeof(struct RuleHeader))
+        && read(fd, x, n * sizeof(double)) == (ssize_t)(n * sizeof(double))
+        && read(fd, w, n * sizeof(double)) == (ssize_t)(n * sizeof(double))
+    );
+    close(fd);
+
+    return ok ? 0 : -1;
+
+}
+
+/**
+ * Creates a directory and its missing parents.
+ */
+static void make_dirs(const char *dir) {
+
+    char path[sizeof(cache.path)];
+    strcpy(path, dir);
+    for (char *p = path + 1; *p; ++p) {
+        if (*p != '/') { continue; }
+        *p = '\0';
+        mkdir(path, 0755);
+        *p = '/';
+    }
+    mkdir(path, 0755);
+
+}
+
+/**
+ * Writes the file of a rule atomically. Failures are ignored, as the cache is only an optimization.
+ */
+static void write_rule(
+    const char *path, const struct RuleHeader *header, const double *x, const double *w
+) {
+
+    make_dirs(cache.path);
+
+    char tmp[sizeof(cache.path) + 64];
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int)sizeof(tmp)) { return; }
+    int fd = mkstemp(tmp);
+    if (fd < 0) { return; }
+
+    const size_t n = header->n;
+    short ok = (
+        write(fd, header, sizeof(struct RuleHeader)) == (ssize_t)sizeof(struct RuleHeader)
+        && write(fd, x, n * sizeof(double)) == (ssize_t)(n * sizeof(double))
+        && write(fd, w, n * sizeof(double)) == (ssize_t)(n * sizeof(double))
+    );
+    ok = !fchmod(fd, 0644) && ok;
+    ok = !close(fd) && ok;
+
+    if (!ok || rename(tmp, path)) { unlink(tmp); }
+
+}
+
+#endif
+
+/**
+ * Writes the nodes and weights of a quadrature rule, reading them from the cache if present, and
+ * computing and caching them otherwise. Rules with fewer than `RULE_CACHE_MIN` nodes are always
+ * computed, as they are cheaper to compute than to read.
+ *
+ * @param family The identifier of the family of the rule
+ * @param n The number of nodes
+ * @param params The `RULE_CACHE_PARAMS` parameters of the family, or `NULL` if it has none
+ * @param build The function computing the rule
+ * @param x The location to which to write the nodes
+ * @param w The location to which to write the weights
+ */
+void load_rule(
+    unsigned int family, unsigned int n, const double *params, RuleBuilder build, double *x, double *w
+) {
+
+#ifndef _WIN32
+    init_cache();
+    if (!cache.enabled || n < RULE_CACHE_MIN) {
+        build(n, x, w);
+        return;
+    }
+
+    struct RuleHeader header;
+    char path[sizeof(cache.path) + 128];
+    fill_header(&header, family, n, params);
+    if (rule_path(path, sizeof(path), &header)) {
+        build(n, x, w);
+        return;
+    }
+
+    if (!read_rule(path, &header, x, w)) { return; }
+    build(n, x, w);
+    write_rule(path, &header, x, w);
+#else
+    build(n, x, w);
+#endif
+
+}
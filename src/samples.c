@@ -0,0 +1,360 @@
+/**
+ * Source file for "../include/samples.h"
+ *
+ * Every rule is linear in the samples, so integrating along an axis reduces to a weighted sum along
+ * that axis with one weight per sample. The weighted sum is computed over strided memory without
+ * copying, with the innermost loop running over unit-stride memory whenever the layout allows it.
+ *
+ * Cumulative integrals are prefix sums of the integrals over each subinterval. Each line along the
+ * axis is split into blocks of `SCAN_BLOCK` values that are scanned independently, then offset by
+ * the totals of the blocks before them. The blocks do not depend on the number of threads, so the
+ * result does not either.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/parallel.h"
+#include "../include/samples.h"
+
+
+/**
+ * Adds the weights of Simpson's rule over a pair of consecutive subintervals of widths `h0` and `h1`,
+ * starting at sample `k`.
+ */
+static void simpson_pair(double h0, double h1, Py_ssize_t k, double *w) {
+
+    const double h = h0 + h1;
+    *(w + k) += h / 6 * (2 - h1 / h0);
+    *(w + k + 1) += h / 6 * h * h / (h0 * h1);
+    *(w + k + 2) += h / 6 * (2 - h0 / h1);
+
+}
+
+/**
+ * Computes the weight of each sample along an axis for a rule. Samples are either equally spaced by
+ * `dx`, or located at the coordinates `x` if not `NULL`.
+ *
+ * With an odd number of subintervals, Simpson's rule covers the last subinterval with the quadratic
+ * through the last three samples. Romberg's method requires `2^k + 1` equally spaced samples and
+ * extrapolates the trapezoidal rules over every `2^j`-th sample; as the extrapolation is linear, its
+ * weights are combinations of the weights of the trapezoidal rules. The rectangle rule weighs each
+ * subinterval by the sample at its start, the last sample being unused.
+ *
+ * @param rule The rule
+ * @param n The number of samples
+ * @param dx The spacing of the samples, if `x` is `NULL`
+ * @param x The coordinates of the samples, or `NULL`
+ * @param w The location to which to write the `n` weights
+ * @return `0` upon success, or `-1` upon failure
+ */
+short sample_weights(enum SampleRule rule, Py_ssize_t n, double dx, const double *x, double *w) {
+
+    memset(w, 0, n * sizeof(double));
+    if (n < 2) { return 0; }
+
+#define WIDTH(k) (x ? *(x + (k) + 1) - *(x + (k)) : dx)
+
+    switch (rule) {
+
+        case SAMPLE_TRAPEZOID:
+            for (Py_ssize_t k = 0; k + 1 < n; ++k) {
+                *(w + k) += WIDTH(k) / 2, *(w + k + 1) += WIDTH(k) / 2;
+            }
+            return 0;
+
+        case SAMPLE_SIMPSON:
+            if (n == 2) { return sample_weights(SAMPLE_TRAPEZOID, n, dx, x, w); }
+            Py_ssize_t k = 0;
+            for (; k + 2 < n; k += 2) { simpson_pair(WIDTH(k), WIDTH(k + 1), k, w); }
+            if (k + 1 < n) {
+                const double h1 = WIDTH(n - 3), h2 = WIDTH(n - 2);
+                *(w + n - 1) += (2 * h2 * h2 + 3 * h1 * h2) / (6 * (h1 + h2));
+                *(w + n - 2) += (h2 * h2 + 3 * h1 * h2) / (6 * h1);
+                *(w + n - 3) -= h2 * h2 * h2 / (6 * h1 * (h1 + h2));
+            }
+            return 0;
+
+        case SAMPLE_RECTANGLE:
+            for (Py_ssize_t k = 0; k + 1 < n; ++k) { *(w + k) += WIDTH(k); }
+            return 0;
+
+        case SAMPLE_ROMBERG: {
+            Py_ssize_t intervals = n - 1;
+            unsigned int m = 0;
+            while (intervals > 1 && intervals % 2 == 0) { intervals /= 2, ++m; }
+            if (x || intervals != 1) {
+                PyErr_SetString(PyExc_ValueError, "Expected 2^k + 1 equally spaced samples for Romberg");
+                return -1;
+            }
+
+            double c[64] = { 0. }, r[64][64];
+            for (unsigned int i = 0; i <= m; ++i) {
+                for (unsigned int j = 0; j <= m; ++j) { r[i][j] = i == j; }
+            }
+            for (unsigned int j = 1; j <= m; ++j) {
+                const double f = (double)(1ULL << (2 * j)) - 1;
+                for (unsigned int i = m; i >= j; --i) {
+                    for (unsigned int l = 0; l <= m; ++l) { r[i][l] += (r[i][l] - r[i - 1][l]) / f; }
+                }
+            }
+            for (unsigned int l = 0; l <= m; ++l) { c[l] = r[m][l]; }
+
+            for (unsigned int l = 0; l <= m; ++l) {
+                const Py_ssize_t step = (Py_ssize_t)1 << (m - l);
+                const double h = dx * step;
+                for (Py_ssize_t k = 0; k < n; k += step) {
+                    *(w + k) += c[l] * (k == 0 || k == n - 1 ? h / 2 : h);
+                }
+            }
+            return 0;
+        }
+
+    }
+
+#undef WIDTH
+
+    PyErr_SetString(PyExc_ValueError, "Invalid sample rule");
+    return -1;
+
+}
+
+/**
+ * Computes the weighted sum of a strided array of 'float' values along one axis, writing the result
+ * in C order with the axis removed. The Python API is not used, so the GIL may be released.
+ *
+ * @param src The address of the first element
+ * @param ndim The number of dimensions
+ * @param shape The size of each dimension
+ * @param strides The stride in bytes of each dimension
+ * @param axis The axis along which to sum
+ * @param w The weight of each sample along `axis`
+ * @param dst The location to which to write the result
+ */
+void reduce_axis(
+    const char *src, int ndim, const Py_ssize_t *shape, const Py_ssize_t *strides, int axis,
+    const double *w, double *dst
+) {
+
+    const Py_ssize_t n = *(shape + axis), sa = *(strides + axis);
+    const int inner = axis == ndim - 1 ? ndim - 2 : ndim - 1;
+    const Py_ssize_t ni = inner >= 0 ? *(shape + inner) : 1, si = inner >= 0 ? *(strides + inner) : 0;
+
+    Py_ssize_t nrows = 1;
+    for (int j = 0; j < ndim; ++j) {
+        if (j != axis && j != inner) { nrows *= *(shape + j); }
+    }
+
+    Py_ssize_t index[PyBUF_MAX_NDIM] = { 0 };
+    const short dot = inner < 0 || (sa < 0 ? -sa : sa) < (si < 0 ? -si : si);
+
+    for (Py_ssize_t row = 0; row < nrows; ++row) {
+
+        const char *base = src;
+        for (int j = 0; j < ndim; ++j) { base += index[j] * *(strides + j); }
+        double *restrict out = dst + row * ni;
+
+        if (dot) {
+            for (Py_ssize_t i = 0; i < ni; ++i) {
+                const char *p = base + i * si;
+                double acc = 0.;
+                if (sa == sizeof(double)) {
+                    const double *restrict y = (const double *)p;
+                    double lanes[SAMPLE_LANES] = { 0. };
+                    Py_ssize_t k = 0;
+                    for (; k + SAMPLE_LANES <= n; k += SAMPLE_LANES) {
+                        for (int j = 0; j < SAMPLE_LANES; ++j) { lanes[j] += *(w + k + j) * *(y + k + j); }
+                    }
+                    for (; k < n; ++k) { acc += *(w + k) * *(y + k); }
+                    for (int j = 0; j < SAMPLE_LANES; ++j) { acc += lanes[j]; }
+                } else {
+                    for (Py_ssize_t k = 0; k < n; ++k) { acc += *(w + k) * *(const double *)(p + k * sa); }
+                }
+                *(out + i) = acc;
+            }
+        } else {
+            memset(out, 0, ni * sizeof(double));
+            for (Py_ssize_t k = 0; k < n; ++k) {
+                const char *p = base + k * sa;
+                const double wk = *(w + k);
+                if (si == sizeof(double)) {
+                    const double *restrict y = (const double *)p;
+                    for (Py_ssize_t i = 0; i < ni; ++i) { *(out + i) += wk * *(y + i); }
+                } else {
+                    for (Py_ssize_t i = 0; i < ni; ++i) { *(out + i) += wk * *(const double *)(p + i * si); }
+                }
+            }
+        }
+
+        for (int j = ndim - 1; j >= 0; --j) {
+            if (j == axis || j == inner) { continue; }
+            if (++index[j] < *(shape + j)) { break; }
+            index[j] = 0;
+        }
+
+    }
+
+}
+
+struct Scan {
+    const char *src;
+    int ndim;
+    const Py_ssize_t *shape;
+    const Py_ssize_t *strides;
+    int axis;
+    enum SampleRule rule;
+    double dx;
+    const double *x;
+    double *dst;
+    Py_ssize_t nout;
+    Py_ssize_t stride;
+    size_t nblocks;
+    double *totals;
+};
+
+/**
+ * Locates line `line` along the axis of a scan, in the samples and in the result.
+ */
+static void scan_line(struct Scan *scan, size_t line, const char **src, double **dst) {
+
+    const char *p = scan->src;
+    Py_ssize_t offset = 0, size = 1;
+    for (int j = scan->ndim - 1; j >= 0; --j) {
+        if (j == scan->axis) {
+            size *= scan->nout;
+            continue;
+        }
+        const Py_ssize_t i = (Py_ssize_t)(line % *(scan->shape + j));
+        line /= *(scan->shape + j);
+        p += i * *(scan->strides + j), offset += i * size;
+        size *= *(scan->shape + j);
+    }
+
+    *src = p, *dst = scan->dst + offset;
+
+}
+
+/**
+ * Scans one block of one line, writing the cumulative integral from the start of the block and the
+ * total of the block.
+ */
+static void scan_block(void *context, unsigned int worker, size_t chunk) {
+
+    struct Scan *scan = (struct Scan *)context;
+    const char *src;
+    double *dst;
+    scan_line(scan, chunk / scan->nblocks, &src, &dst);
+
+    const Py_ssize_t sa = *(scan->strides + scan->axis);
+    const Py_ssize_t lo = (Py_ssize_t)(chunk % scan->nblocks) * SCAN_BLOCK;
+    const Py_ssize_t hi = lo + SCAN_BLOCK < scan->nout ? lo + SCAN_BLOCK : scan->nout;
+
+#define SAMPLE(k) (*(const double *)(src + (k) * sa))
+#define WIDTH(k) (scan->x ? *(scan->x + (k) + 1) - *(scan->x + (k)) : scan->dx)
+
+    double sum = 0.;
+    for (Py_ssize_t k = lo ? lo : 1; k < hi; ++k) {
+        if (scan->rule == SAMPLE_RECTANGLE) {
+            sum += SAMPLE(k - 1) * WIDTH(k - 1);
+        } else {
+            sum += (SAMPLE(k - 1) + SAMPLE(k)) / 2 * WIDTH(k - 1);
+        }
+        *(dst + k * scan->stride) = sum;
+    }
+    if (!lo && hi) { *dst = 0.; }
+    *(scan->totals + chunk) = sum;
+
+#undef SAMPLE
+#undef WIDTH
+
+}
+
+/**
+ * Offsets one block of one line by the totals of the blocks before it.
+ */
+static void offset_block(void *context, unsigned int worker, size_t chunk) {
+
+    struct Scan *scan = (struct Scan *)context;
+    const double offset = *(scan->totals + chunk);
+    if (offset == 0.) { return; }
+
+    const char *src;
+    double *dst;
+    scan_line(scan, chunk / scan->nblocks, &src, &dst);
+
+    const Py_ssize_t lo = (Py_ssize_t)(chunk % scan->nblocks) * SCAN_BLOCK;
+    const Py_ssize_t hi = lo + SCAN_BLOCK < scan->nout ? lo + SCAN_BLOCK : scan->nout;
+    for (Py_ssize_t k = lo; k < hi; ++k) { *(dst + k * scan->stride) += offset; }
+
+}
+
+/**
+ * Computes the cumulative integral of a strided array of 'float' values along one axis with the
+ * trapezoidal or rectangle rule, writing the result in C order. The result has the shape of the
+ * samples, except one more value along the axis with the rectangle rule; its first value along the
+ * axis is always `0`. The caller must hold the GIL, which is released during the computation.
+ *
+ * @param src The address of the first element
+ * @param ndim The number of dimensions
+ * @param shape The size of each dimension
+ * @param strides The stride in bytes of each dimension
+ * @param axis The axis along which to integrate
+ * @param rule The rule, either `SAMPLE_TRAPEZOID` or `SAMPLE_RECTANGLE`
+ * @param dx The spacing of the samples, if `x` is `NULL`
+ * @param x The coordinates of the samples along the axis, or `NULL`
+ * @param nthreads The number of threads to use
+ * @param dst The location to which to write the result
+ * @return `0` upon success, or `-1` upon failure
+ */
+short cumulate_axis(
+    const char *src, int ndim, const Py_ssize_t *shape, const Py_ssize_t *strides, int axis,
+    enum SampleRule rule, double dx, const double *x, unsigned int nthreads, double *dst
+) {
+
+    if (rule != SAMPLE_TRAPEZOID && rule != SAMPLE_RECTANGLE) {
+        PyErr_SetString(PyExc_ValueError, "Expected the trapezoidal or rectangle rule");
+        return -1;
+    }
+
+    const Py_ssize_t nout = *(shape + axis) + (rule == SAMPLE_RECTANGLE);
+    Py_ssize_t stride = 1;
+    size_t nlines = 1;
+    for (int j = ndim - 1; j >= 0; --j) {
+        if (j > axis) { stride *= *(shape + j); }
+        if (j != axis) { nlines *= *(shape + j); }
+    }
+
+    struct Scan scan = {
+        .src = src, .ndim = ndim, .shape = shape, .strides = strides, .axis = axis, .rule = rule,
+        .dx = dx, .x = x, .dst = dst, .nout = nout, .stride = stride,
+        .nblocks = nout ? (size_t)((nout + SCAN_BLOCK - 1) / SCAN_BLOCK) : 1, .totals = NULL
+    };
+    if (!nlines) { return 0; }
+
+    if (!(scan.totals = (double *)calloc(nlines * scan.nblocks, sizeof(double)))) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        return -1;
+    }
+    if (parallel_for(nthreads, nlines * scan.nblocks, scan_block, &scan) == -1) {
+        free(scan.totals);
+        return -1;
+    }
+
+    if (scan.nblocks > 1) {
+        for (size_t line = 0; line < nlines; ++line) {
+            double *totals = scan.totals + line * scan.nblocks, offset = 0.;
+            for (size_t b = 0; b < scan.nblocks; ++b) {
+                const double total = *(totals + b);
+                *(totals + b) = offset, offset += total;
+            }
+        }
+        if (parallel_for(nthreads, nlines * scan.nblocks, offset_block, &scan) == -1) {
+            free(scan.totals);
+            return -1;
+        }
+    }
+    free(scan.totals);
+
+    return 0;
+
+}
@@ -0,0 +1,103 @@
+/**
+ * Source file for "../include/stencils.h"
+ *
+ * Stencils are built on first use and kept for the lifetime of the process in a list owned by this
+ * file, so that the weights returned by `get_stencil` remain valid without the caller freeing them.
+ */
+
+#include <stdlib.h>
+
+#include "../include/stencils.h"
+
+
+static struct Stencil *stencils = NULL;
+
+/**
+ * Computes the weights of the finite difference approximation of the `m`th derivative at `0` of a
+ * function sampled at offsets `z`, by Fornberg's recurrences over the number of offsets.
+ *
+ * @param m The order of the derivative
+ * @param z The offsets of the samples
+ * @param n The number of offsets, greater than `m`
+ * @param w The location to which to write the `n` weights
+ */
+void fornberg(unsigned int m, const double *z, unsigned int n, double *w) {
+
+    double c[STENCIL_MAX_POINTS][STENCIL_MAX_POINTS] = { { 0. } };
+    double c1 = 1., c4 = *z;
+    c[0][0] = 1.;
+
+    for (unsigned int i = 1; i < n; ++i) {
+
+        const unsigned int mn = i < m ? i : m;
+        double c2 = 1., c5 = c4;
+        c4 = *(z + i);
+
+        for (unsigned int j = 0; j < i; ++j) {
+            const double c3 = *(z + i) - *(z + j);
+            c2 *= c3;
+            if (j == i - 1) {
+                for (unsigned int k = mn; k > 0; --k) {
+                    c[i][k] = c1 * (k * c[i - 1][k - 1] - c5 * c[i - 1][k]) / c2;
+                }
+                c[i][0] = -c1 * c5 * c[i - 1][0] / c2;
+            }
+            for (unsigned int k = mn; k > 0; --k) { c[j][k] = (c4 * c[j][k] - k * c[j][k - 1]) / c3; }
+            c[j][0] = c4 * c[j][0] / c3;
+        }
+        c1 = c2;
+
+    }
+
+    for (unsigned int i = 0; i < n; ++i) { *(w + i) = c[i][m]; }
+
+}
+
+/**
+ * Returns the finite difference stencil of a derivative order, accuracy order and rule, building it
+ * on first use. Forward and backward stencils of accuracy `p` span `order + p` consecutive offsets
+ * ending or starting at `0`; central stencils have an even accuracy `p` and span `order + p - 1`
+ * consecutive offsets centered at `0`, which are half-integers for odd orders. Offsets are thus one
+ * step apart for every rule, as in the first- and second-order rules of `dquotient`. The caller must
+ * hold the GIL.
+ *
+ * @param order The order of the derivative
+ * @param accuracy The order of accuracy, or `0` for the lowest of the rule
+ * @param rule The type of finite difference
+ * @return The stencil, or `NULL` upon failure
+ */
+const struct Stencil *get_stencil(unsigned int order, unsigned int accuracy, enum StencilRule rule) {
+
+    if (!accuracy) { accuracy = rule == STENCIL_CENTRAL ? 2 : 1; }
+    if (rule == STENCIL_CENTRAL) { accuracy += accuracy % 2; }
+
+    for (struct Stencil *s = stencils; s; s = s->next) {
+        if (s->order == order && s->accuracy == accuracy && s->rule == rule) { return s; }
+    }
+
+    const unsigned int n = rule == STENCIL_CENTRAL ? order + accuracy - 1 : order + accuracy;
+    if (n > STENCIL_MAX_POINTS) {
+        PyErr_Format(
+            PyExc_ValueError, "Expected a stencil of at most %d points, not %u", STENCIL_MAX_POINTS, n
+        );
+        return NULL;
+    }
+
+    struct Stencil *s = (struct Stencil *)malloc(sizeof(struct Stencil));
+    double *offsets = (double *)malloc(2 * n * sizeof(double));
+    if (!s || !offsets) {
+        PyErr_SetString(PyExc_MemoryError, "Failed to allocate memory");
+        free(s); free(offsets);
+        return NULL;
+    }
+
+    const double first = rule == STENCIL_FORWARD ? 0. : rule == STENCIL_BACKWARD ? 1. - n : (1. - n) / 2;
+    for (unsigned int i = 0; i < n; ++i) { *(offsets + i) = first + i; }
+
+    *s = (struct Stencil){ order, accuracy, rule, n, offsets, offsets + n, stencils };
+    fornberg(order, s->offsets, n, s->weights);
+    stencils = s;
+
+    return s;
+
+}
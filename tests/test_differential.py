@@ -0,0 +1,110 @@
+"""
+Tests of the differential extension, comparing each differentiator against closed-form derivatives.
+"""
+
+import array
+import cmath
+import math
+import unittest
+
+from pync import differential
+
+FORWARD, BACKWARD, CENTRAL = 0, 1, 2
+
+
+def view(values, shape):
+    """
+    Returns a C-contiguous buffer of doubles with the given shape.
+    """
+    return memoryview(array.array("d", values)).cast("B").cast("d", shape)
+
+
+def f(x):
+    return x[0] ** 2 * x[1] + math.sin(x[2]) * x[0] + x[1] ** 3
+
+
+def gradient(x):
+    return [2 * x[0] * x[1] + math.sin(x[2]), x[0] ** 2 + 3 * x[1] ** 2, math.cos(x[2]) * x[0]]
+
+
+def hessian(x):
+    return [[2 * x[1], 2 * x[0], math.cos(x[2])], [2 * x[0], 6 * x[1], 0.],
+            [math.cos(x[2]), 0., -math.sin(x[2]) * x[0]]]
+
+
+class TestQuotient(unittest.TestCase):
+
+    x = [.3, .7]
+    g = staticmethod(lambda x: math.exp(x[0]) * math.sin(x[1]))
+
+    def exact(self, n):
+        return [math.exp(.3) * math.sin(.7), math.exp(.3) * math.sin(.7 + n * math.pi / 2)]
+
+    def test_dquotient(self):
+        for n in (1, 2, 3):
+            for rule in (FORWARD, BACKWARD, CENTRAL):
+                res = differential.dquotient(self.g, self.x, 1e-2, n, rule, 4)
+                for a, b in zip(res, self.exact(n)):
+                    self.assertAlmostEqual(a, b, delta=1e-4)
+
+    def test_dquotient_accuracy(self):
+        g = lambda x: x[0] ** 3
+        self.assertEqual(differential.dquotient(g, [1.], .1, 1, CENTRAL),
+                         differential.dquotient(g, [1.], .1, 1, CENTRAL, 2))
+
+    def test_ridders(self):
+        for n in (1, 2):
+            for rule in (FORWARD, BACKWARD, CENTRAL):
+                res, err = differential.ridders(self.g, self.x, .5, n, rule)
+                for a, b in zip(res, self.exact(n)):
+                    self.assertAlmostEqual(a, b, delta=1e-6)
+
+    def test_order(self):
+        for method in (differential.dquotient, differential.ridders):
+            with self.assertRaises(ValueError):
+                method(self.g, self.x, 1e-2, 0, CENTRAL)
+
+
+class TestBatch(unittest.TestCase):
+
+    points = [1., 2., .5, 0., 1., 0., -1., 3., 2.]
+
+    def test_gradient(self):
+        x = view(self.points, (3, 3))
+        for rule in (FORWARD, BACKWARD, CENTRAL):
+            res = differential.gradient(f, x, 1e-6, rule)
+            self.assertEqual(res.shape, (3, 3))
+            for row, point in zip(res.tolist(), x.tolist()):
+                for a, b in zip(row, gradient(point)):
+                    self.assertAlmostEqual(a, b, places=4)
+
+    def test_gradient_vectorized(self):
+        x = view(self.points, (3, 3))
+        g = lambda block: [f(point) for point in block.tolist()]
+        self.assertEqual(differential.gradient(g, x, 1e-6, CENTRAL, 8).tolist(),
+                         differential.gradient(f, x, 1e-6, CENTRAL).tolist())
+
+    def test_hessian(self):
+        x = view(self.points[:3], (3,))
+        res = differential.hessian(f, x, 1e-4, CENTRAL)
+        for row, ref in zip(res.tolist(), hessian(self.points[:3])):
+            for a, b in zip(row, ref):
+                self.assertAlmostEqual(a, b, places=5)
+
+    def test_jacobian(self):
+        g = lambda x: [x[0] * x[1], math.exp(x[0]), x[2] ** 2]
+        res = differential.jacobian(g, view(self.points[:3], (1, 3)), 1e-6, CENTRAL)
+        ref = [[2., 1., 0.], [math.e, 0., 0.], [0., 0., 1.]]
+        for row, exact in zip(res.tolist()[0], ref):
+            for a, b in zip(row, exact):
+                self.assertAlmostEqual(a, b, places=6)
+
+    def test_complex_step(self):
+        g = lambda z: cmath.exp(z[0]) * cmath.sin(z[1])
+        res = differential.complex_step(g, view([.3, .7], (2,))).tolist()
+        self.assertAlmostEqual(res[0], math.exp(.3) * math.sin(.7), places=14)
+        self.assertAlmostEqual(res[1], math.exp(.3) * math.cos(.7), places=14)
+
+
+if __name__ == "__main__":
+    unittest.main()
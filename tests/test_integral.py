@@ -0,0 +1,180 @@
+"""
+Tests of the integral extension, comparing each integrator against closed forms and pure-Python references.
+"""
+
+import array
+import itertools
+import math
+import unittest
+
+from pync import integral
+
+
+def view(values, shape):
+    """
+    Returns a C-contiguous buffer of doubles with the given shape.
+    """
+    return memoryview(array.array("d", values)).cast("B").cast("d", shape)
+
+
+def reference_cumtrapz(values, shape, dx, axes):
+    """
+    Cumulative trapezoidal integral of a flat row-major array, accumulated along each axis in turn.
+    """
+    strides = [math.prod(shape[a + 1:]) for a in range(len(shape))]
+    res = list(values)
+    for axis, h in zip(axes, dx):
+        prev, res = res, [0.] * len(res)
+        for idx in itertools.product(*map(range, shape)):
+            if idx[axis]:
+                k = sum(i * s for i, s in zip(idx, strides))
+                res[k] = res[k - strides[axis]] + h * (prev[k] + prev[k - strides[axis]]) / 2
+    return res
+
+
+def flatten(obj):
+    """
+    Flattens the nested lists returned by ``memoryview.tolist`` in row-major order.
+    """
+    return list(itertools.chain.from_iterable(map(flatten, obj))) if isinstance(obj, list) else [obj]
+
+
+class TestAdaptive(unittest.TestCase):
+
+    f = staticmethod(lambda x: math.exp(x[0]))
+    exact = math.e - 1
+
+    def test_quad(self):
+        value, error, neval = integral.quad(self.f, [integral.Interval(0., 1.)], 1e-10)
+        self.assertAlmostEqual(value, self.exact, places=10)
+        self.assertLess(error, 1e-10)
+        self.assertGreater(neval, 0)
+
+    def test_romberg(self):
+        value, error = integral.romberg(self.f, [integral.Interval(0., 1.)], 1e-10)[:2]
+        self.assertAlmostEqual(value, self.exact, places=10)
+        self.assertLess(error, 1e-10)
+
+    def test_tanhsinh(self):
+        value = integral.tanhsinh(lambda x: 1 / math.sqrt(x[0]), [integral.Interval(0., 1.)], 1e-12)[0]
+        self.assertAlmostEqual(value, 2., places=10)
+        value = integral.tanhsinh(lambda x: math.exp(-x[0]), [integral.Interval(0., math.inf)], 1e-12)[0]
+        self.assertAlmostEqual(value, 1., places=10)
+
+    def test_sparse(self):
+        value = integral.sparse(lambda x: math.exp(sum(x)), [integral.Interval(0., 1.)] * 3, 1e-10)[0]
+        self.assertAlmostEqual(value, self.exact ** 3, places=8)
+
+
+class TestSampling(unittest.TestCase):
+
+    f = staticmethod(lambda x: math.prod(1 + (xi - .5) / (j + 1) for j, xi in enumerate(x)))
+
+    def test_qmc(self):
+        for rule in (integral.SOBOL, integral.HALTON, integral.LATTICE):
+            value, error = integral.qmc(self.f, [integral.Interval(0., 1.)] * 4, 4096, rule, 8, 1)[:2]
+            self.assertAlmostEqual(value, 1., delta=max(10 * error, 1e-6))
+
+    def test_vegas(self):
+        intervals = [integral.Interval(0., 2.), integral.Interval(0., 1.)]
+        value, error = integral.vegas(lambda x: x[0] * x[1], intervals, 4000, 5, 7)[:2]
+        self.assertAlmostEqual(value, 1., delta=max(10 * error, 1e-3))
+        self.assertEqual(integral.vegas(lambda x: x[0] * x[1], intervals, 4000, 5, 7)[0], value)
+
+
+class TestGrid(unittest.TestCase):
+
+    intervals = [integral.Interval(0., 1., 10)] * 2
+    f = staticmethod(lambda x: math.exp(x[0] + x[1]))
+
+    def test_tensor(self):
+        value = integral.tensor(self.f, self.intervals, [integral.GAUSS_LEGENDRE] * 2)
+        self.assertAlmostEqual(value, (math.e - 1) ** 2, places=12)
+        self.assertEqual(integral.tensor(self.f, self.intervals, [integral.TRAPEZOID] * 2),
+                         integral.trapezoidal(self.f, self.intervals))
+        with self.assertRaises(ValueError):
+            integral.tensor(self.f, [integral.Interval(0., 1., 3)], [integral.SIMPSON])
+
+    def test_rule(self):
+        nodes, weights = integral.rule(integral.GAUSS_LEGENDRE, 20)
+        self.assertEqual(len(nodes), 20)
+        self.assertAlmostEqual(sum(weights), 2., places=12)
+        self.assertAlmostEqual(sum(w * x ** 10 for x, w in zip(nodes, weights)), 2 / 11, places=12)
+
+    def test_plan(self):
+        plan = integral.Plan(self.intervals)
+        self.assertEqual(plan.integrate(self.f), integral.trapezoidal(self.f, self.intervals))
+        many = plan.integrate_many([self.f, lambda x: 1.])
+        self.assertEqual(many[0], plan.integrate(self.f))
+        self.assertAlmostEqual(many[1], 1., places=12)
+        g = lambda x: x[0] ** 2
+        self.assertAlmostEqual(plan.separable([g, g]), integral.trapezoidal(lambda x: g(x) * x[1] ** 2,
+                                                                            self.intervals), places=12)
+
+    def test_separable(self):
+        g = lambda x: x[0] ** 2
+        res = integral.separable([g] * 3, [integral.Interval(0., 1., 200)] * 3, [integral.MIDPOINT] * 3)
+        self.assertAlmostEqual(res, (1 / 3) ** 3, places=5)
+        with self.assertRaises(ValueError):
+            integral.separable([g], self.intervals)
+
+    def test_sweep(self):
+        intervals = [integral.Interval(0., math.pi, 200)]
+        params = [float(k) for k in range(4)]
+        res = integral.sweep(lambda x, p: math.cos(p[0] * x[0]), intervals, params)
+        ref = [integral.trapezoidal(lambda x, k=k: math.cos(k * x[0]), intervals) for k in params]
+        self.assertEqual(res.tolist(), ref)
+        res = integral.Plan(intervals).sweep(lambda x, p: math.cos(p[0] * x[0]), params)
+        self.assertEqual(res.tolist(), ref)
+
+    def test_progressive(self):
+        intervals = [integral.Interval(0., 1., 100)]
+        g = lambda x: math.exp(x[0])
+        estimate, fraction = integral.progressive(g, intervals)
+        self.assertEqual(fraction, 1.)
+        self.assertAlmostEqual(estimate, integral.trapezoidal(g, intervals), places=12)
+
+    def test_vector_valued(self):
+        res = integral.trapezoidal(lambda x: [x[0] ** k for k in range(4)], [integral.Interval(0., 1., 1000)])
+        for k in range(4):
+            self.assertAlmostEqual(res[k], 1 / (k + 1), places=6)
+
+
+class TestSamples(unittest.TestCase):
+
+    def test_trapz_simpson_romb(self):
+        n = 17
+        y = view([math.exp(k / (n - 1)) for k in range(n)], (n,))
+        self.assertAlmostEqual(integral.trapz(y, 1 / (n - 1)), math.e - 1, delta=1e-3)
+        self.assertAlmostEqual(integral.simpson(y, 1 / (n - 1)), math.e - 1, places=6)
+        self.assertAlmostEqual(integral.romb(y, 1 / (n - 1)), math.e - 1, places=10)
+
+    def test_trapz_axis(self):
+        shape = (5, 7)
+        values = [i * 10 + j * j for i in range(shape[0]) for j in range(shape[1])]
+        res = integral.trapz(view(values, shape), 1., 0)
+        ref = reference_cumtrapz(values, shape, [1.], [0])[-shape[1]:]
+        self.assertEqual(res.shape, (shape[1],))
+        for a, b in zip(res.tolist(), ref):
+            self.assertAlmostEqual(a, b, places=12)
+
+    def test_cumtrapz(self):
+        cases = (((3, 4, 5), (.5, 2., 1.5), (0, 1, 2)), ((2, 3, 4, 5), (.5, 2., 1.5, .25), (0, 1, 2, 3)),
+                 ((2, 3, 4, 5), (.5, 2.), (1, 3)), ((3, 4, 5), .5, 1))
+        for shape, dx, axes in cases:
+            values = [math.sin(k) + k / 10 for k in range(math.prod(shape))]
+            ref = reference_cumtrapz(values, shape, dx if isinstance(axes, tuple) else [dx],
+                                     axes if isinstance(axes, tuple) else [axes])
+            for nthreads in (1, 3):
+                res = integral.cumtrapz(view(values, shape), dx, axes, nthreads)
+                self.assertEqual(res.shape, shape)
+                for a, b in zip(flatten(res.tolist()), ref):
+                    self.assertAlmostEqual(a, b, places=10)
+
+    def test_cumulative(self):
+        res = integral.cumulative(lambda x: x[0], [integral.Interval(0., 1., 4)])
+        self.assertEqual(res.tolist(), [0., .03125, .125, .28125, .5])
+
+
+if __name__ == "__main__":
+    unittest.main()
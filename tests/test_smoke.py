@@ -0,0 +1,50 @@
+"""
+Smoke tests importing the integral and differential extensions and running basic computations.
+
+The extensions are loaded directly from the package directory, so that they are covered independently
+of the other modules imported by the package.
+"""
+
+import importlib.machinery
+import importlib.util
+import math
+import unittest
+
+
+def load(name):
+    """
+    Loads an extension module of the ``pync`` package without importing the package itself.
+    """
+    package = importlib.util.find_spec("pync")
+    spec = importlib.machinery.PathFinder.find_spec(name, package.submodule_search_locations)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+
+integral = load("integral")
+differential = load("differential")
+
+
+class TestIntegral(unittest.TestCase):
+
+    def test_riemann(self):
+        intervals = [integral.Interval(0., 1., 1000), integral.Interval(0., 2., 1000)]
+        res = integral.riemann(lambda x: x[0] * x[1], intervals, [integral.MIDPOINT, integral.MIDPOINT])
+        self.assertAlmostEqual(res, 1., places=6)
+
+    def test_trapezoidal(self):
+        intervals = [integral.Interval(0., math.pi, 1000)]
+        self.assertAlmostEqual(integral.trapezoidal(lambda x: math.sin(x[0]), intervals), 2., places=5)
+
+
+class TestDifferential(unittest.TestCase):
+
+    def test_dquotient(self):
+        res = differential.dquotient(lambda x: x[0] ** 2 * x[1], [1., 2.], 1e-5, 1, 2)
+        self.assertAlmostEqual(res[0], 4., places=6)
+        self.assertAlmostEqual(res[1], 1., places=6)
+
+
+if __name__ == "__main__":
+    unittest.main()